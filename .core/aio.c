@@ -0,0 +1,405 @@
+/*
+
+    OneCoreAI - Asynchronous File I/O
+
+    Batched reads, writes and fsyncs for checkpointing and dataset loading.
+    The primary backend is io_uring, driven through raw syscalls and the
+    mmap'd submission/completion rings (no liburing). Where io_uring is
+    unavailable (old kernel, seccomp) a small pread/pwrite thread pool
+    runs the same requests. Ops in a batch may be linked so each runs only
+    after the previous one succeeded (write -> fsync).
+
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "handle.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define AIO_HAVE_URING 1
+#endif
+
+#define AIO_RING_ENTRIES 256
+#define AIO_POOL_THREADS 4
+
+static pthread_once_t aio_once = PTHREAD_ONCE_INIT;
+static int aio_backend = -1;              // AIO_BACKEND_*
+
+enum { AIO_BACKEND_URING, AIO_BACKEND_POOL };
+
+static struct {
+    _Atomic unsigned long batches;
+    _Atomic unsigned long ops;
+    _Atomic unsigned long bytes;
+    _Atomic unsigned long enters;         // io_uring_enter calls
+    _Atomic unsigned long inline_ops;     // Ran synchronously (ring full)
+} aio_stats;
+
+// Run one op with plain syscalls
+static ssize_t aio_run_sync(AioOp *op) {
+    ssize_t result;
+    switch (op->opcode) {
+        case AIO_READ:
+            result = pread(op->fd, op->buf, op->len, op->offset);
+            break;
+        case AIO_WRITE:
+            result = pwrite(op->fd, op->buf, op->len, op->offset);
+            break;
+        default:
+            result = fsync(op->fd);
+            break;
+    }
+    return result < 0 ? -errno : result;
+}
+
+static void aio_complete(AioOp *op, ssize_t result) {
+    op->result = result;
+    if (result > 0 && op->opcode != AIO_FSYNC) {
+        atomic_fetch_add_explicit(&aio_stats.bytes, (unsigned long)result, memory_order_relaxed);
+    }
+    atomic_store_explicit(&op->done, 1, memory_order_release);
+}
+
+// A chain breaks (like io_uring links) when an op fails or transfers short
+static int aio_chain_ok(const AioOp *op, ssize_t result) {
+    return result >= 0 && (op->opcode == AIO_FSYNC || (size_t)result == op->len);
+}
+
+// Run a linked chain synchronously, cancelling the rest after a failure
+// (all of it if ok is 0: the op it continues failed)
+static void aio_run_chain(AioOp *op, int ok) {
+    for (; op; op = op->link ? op->chain : NULL) {
+        ssize_t result = ok ? aio_run_sync(op) : -ECANCELED;
+        ok = ok && aio_chain_ok(op, result);
+        aio_complete(op, result);
+        if (!op->link) break;
+    }
+}
+
+// io_uring backend
+
+#ifdef AIO_HAVE_URING
+static struct {
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    unsigned entries;
+    _Atomic unsigned inflight;            // Submitted, not yet reaped
+    pthread_mutex_t submit_lock;          // SQ ring
+    pthread_mutex_t complete_lock;        // CQ ring; held by the one thread waiting in the kernel
+} ring = {
+    .fd = -1,
+    .submit_lock = PTHREAD_MUTEX_INITIALIZER,
+    .complete_lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+static int uring_setup() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, AIO_RING_ENTRIES, &params);
+    if (fd < 0) {
+        return -1;
+    }
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    int single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && cq_size > sq_size) sq_size = cq_size;
+
+    char *sq = mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    char *cq = sq;
+    if (!single) {
+        cq = mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED) {
+            munmap(sq, sq_size);
+            close(fd);
+            return -1;
+        }
+    }
+    void *sqes = mmap(NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (!single) munmap(cq, cq_size);
+        munmap(sq, sq_size);
+        close(fd);
+        return -1;
+    }
+
+    ring.fd = fd;
+    ring.sq_head = (unsigned *)(sq + params.sq_off.head);
+    ring.sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring.sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring.sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring.cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring.cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring.cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    ring.sqes = sqes;
+    ring.entries = params.sq_entries;
+    return 0;
+}
+
+static int uring_enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    atomic_fetch_add_explicit(&aio_stats.enters, 1, memory_order_relaxed);
+    int result;
+    do {
+        result = (int)syscall(__NR_io_uring_enter, ring.fd, to_submit, min_complete, flags, NULL, 0);
+    } while (result < 0 && errno == EINTR);
+    return result;
+}
+
+// Queue a batch as SQEs and submit it with one syscall. Returns how many
+// ops the kernel took (the rest are for the caller to run).
+static int uring_submit(AioOp *ops, int count) {
+    pthread_mutex_lock(&ring.submit_lock);
+    if (atomic_load(&ring.inflight) + count > ring.entries) {
+        pthread_mutex_unlock(&ring.submit_lock);
+        return 0;
+    }
+
+    unsigned start = *ring.sq_tail;
+    unsigned tail = start;
+    for (int i = 0; i < count; i++) {
+        AioOp *op = &ops[i];
+        unsigned index = tail & *ring.sq_mask;
+        struct io_uring_sqe *sqe = &ring.sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+
+        op->iov.iov_base = op->buf;
+        op->iov.iov_len = op->len;
+        sqe->fd = op->fd;
+        sqe->off = (uint64_t)op->offset;
+        sqe->user_data = (uint64_t)(uintptr_t)op;
+        if (op->opcode == AIO_FSYNC) {
+            sqe->opcode = IORING_OP_FSYNC;
+        } else {
+            sqe->opcode = op->opcode == AIO_READ ? IORING_OP_READV : IORING_OP_WRITEV;
+            sqe->addr = (uint64_t)(uintptr_t)&op->iov;
+            sqe->len = 1;
+        }
+        if (op->link && i + 1 < count) sqe->flags |= IOSQE_IO_LINK;
+
+        ring.sq_array[index] = index;
+        tail++;
+    }
+    atomic_fetch_add(&ring.inflight, count);
+    atomic_store_explicit((_Atomic unsigned *)ring.sq_tail, tail, memory_order_release);
+
+    int submitted = 0;
+    while (submitted < count) {
+        int result = uring_enter(count - submitted, 0, 0);
+        if (result <= 0) break;
+        submitted += result;
+    }
+    if (submitted < count) {
+        // Take back what the kernel did not consume
+        unsigned head = atomic_load_explicit((_Atomic unsigned *)ring.sq_head, memory_order_acquire);
+        submitted = (int)(head - start);
+        atomic_store_explicit((_Atomic unsigned *)ring.sq_tail, head, memory_order_release);
+        atomic_fetch_sub(&ring.inflight, count - submitted);
+    }
+    pthread_mutex_unlock(&ring.submit_lock);
+    return submitted;
+}
+
+// Reap every available completion (caller holds complete_lock)
+static void uring_reap() {
+    unsigned head = *ring.cq_head;
+    unsigned tail = atomic_load_explicit((_Atomic unsigned *)ring.cq_tail, memory_order_acquire);
+    unsigned reaped = 0;
+    for (; head != tail; head++, reaped++) {
+        struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+        aio_complete((AioOp *)(uintptr_t)cqe->user_data, cqe->res);
+    }
+    atomic_store_explicit((_Atomic unsigned *)ring.cq_head, head, memory_order_release);
+    atomic_fetch_sub(&ring.inflight, reaped);
+}
+
+static void uring_wait(AioOp *op) {
+    pthread_mutex_lock(&ring.complete_lock);
+    while (!atomic_load_explicit(&op->done, memory_order_acquire)) {
+        uring_reap();
+        if (atomic_load_explicit(&op->done, memory_order_acquire)) break;
+        uring_enter(0, 1, IORING_ENTER_GETEVENTS);
+    }
+    pthread_mutex_unlock(&ring.complete_lock);
+}
+#endif
+
+// Thread pool backend
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    AioOp *head;                          // Chains waiting for a thread
+    AioOp *tail;
+} pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER
+};
+
+static void *pool_worker(void *arg) {
+    (void)arg;
+    while (1) {
+        pthread_mutex_lock(&pool.lock);
+        while (!pool.head) {
+            pthread_cond_wait(&pool.work, &pool.lock);
+        }
+        AioOp *op = pool.head;
+        pool.head = op->next;
+        if (!pool.head) pool.tail = NULL;
+        pthread_mutex_unlock(&pool.lock);
+
+        aio_run_chain(op, 1);
+
+        pthread_mutex_lock(&pool.lock);
+        pthread_cond_broadcast(&pool.done);
+        pthread_mutex_unlock(&pool.lock);
+    }
+    return NULL;
+}
+
+static int pool_start() {
+    int started = 0;
+    for (int i = 0; i < AIO_POOL_THREADS; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, pool_worker, NULL) == 0) {
+            pthread_detach(thread);
+            started++;
+        }
+    }
+    return started > 0 ? 0 : -1;
+}
+
+static void pool_submit(AioOp *ops, int count) {
+    pthread_mutex_lock(&pool.lock);
+    for (int i = 0; i < count; i++) {
+        // Only chain heads are queued; the rest run after them on the same thread
+        if (i > 0 && ops[i - 1].link) continue;
+        ops[i].next = NULL;
+        if (pool.tail) pool.tail->next = &ops[i];
+        else pool.head = &ops[i];
+        pool.tail = &ops[i];
+    }
+    pthread_cond_broadcast(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+}
+
+static void pool_wait(AioOp *op) {
+    pthread_mutex_lock(&pool.lock);
+    while (!atomic_load_explicit(&op->done, memory_order_acquire)) {
+        pthread_cond_wait(&pool.done, &pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+}
+
+// Public interface
+
+static void aio_init() {
+#ifdef AIO_HAVE_URING
+    if (getenv("ONECORE_NO_URING") == NULL && uring_setup() == 0) {
+        aio_backend = AIO_BACKEND_URING;
+        return;
+    }
+#endif
+    aio_backend = AIO_BACKEND_POOL;
+    if (pool_start() != 0) {
+        aio_backend = -1;                 // Everything runs inline
+    }
+}
+
+const char *aio_backend_name() {
+    pthread_once(&aio_once, aio_init);
+    return aio_backend == AIO_BACKEND_URING ? "io_uring" :
+           aio_backend == AIO_BACKEND_POOL ? "thread pool" : "synchronous";
+}
+
+// Submit a batch of ops. op->link chains an op to the next one in the
+// array: it only runs if the previous op transferred everything.
+void aio_submit(AioOp *ops, int count) {
+    pthread_once(&aio_once, aio_init);
+    if (count <= 0) {
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        atomic_store_explicit(&ops[i].done, 0, memory_order_relaxed);
+        ops[i].result = 0;
+        ops[i].chain = ops[i].link && i + 1 < count ? &ops[i + 1] : NULL;
+    }
+    atomic_fetch_add_explicit(&aio_stats.batches, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&aio_stats.ops, count, memory_order_relaxed);
+
+    int first = 0;
+#ifdef AIO_HAVE_URING
+    if (aio_backend == AIO_BACKEND_URING) {
+        first = uring_submit(ops, count);
+    }
+#endif
+    if (first < count && aio_backend == AIO_BACKEND_POOL) {
+        pool_submit(ops, count);
+        return;
+    }
+
+    // Ring full or no backend: run the rest here
+    atomic_fetch_add_explicit(&aio_stats.inline_ops, count - first, memory_order_relaxed);
+    for (int i = first; i < count; i++) {
+        int ok = 1;
+        if (i > 0 && ops[i - 1].link) {
+            if (i > first) continue;
+            // The kernel took the start of this chain: run the rest only
+            // after it completes, as the link would have
+            ok = aio_chain_ok(&ops[i - 1], aio_wait(&ops[i - 1]));
+        }
+        aio_run_chain(&ops[i], ok);
+    }
+}
+
+// Wait for one op; returns its result (bytes transferred or -errno)
+ssize_t aio_wait(AioOp *op) {
+    if (!atomic_load_explicit(&op->done, memory_order_acquire)) {
+#ifdef AIO_HAVE_URING
+        if (aio_backend == AIO_BACKEND_URING) uring_wait(op);
+        else
+#endif
+        pool_wait(op);
+    }
+    return op->result;
+}
+
+// Wait for a whole batch; returns 0 if every op succeeded in full
+int aio_wait_all(AioOp *ops, int count) {
+    int result = 0;
+    for (int i = 0; i < count; i++) {
+        if (!aio_chain_ok(&ops[i], aio_wait(&ops[i]))) {
+            result = -1;
+        }
+    }
+    return result;
+}
+
+void aio_report() {
+    printf("Async I/O backend: %s\n", aio_backend_name());
+    printf("  Batches: %lu, Ops: %lu (%lu run inline), Bytes: %.2f MB\n",
+           atomic_load(&aio_stats.batches), atomic_load(&aio_stats.ops),
+           atomic_load(&aio_stats.inline_ops), atomic_load(&aio_stats.bytes) / 1e6);
+    if (aio_backend == AIO_BACKEND_URING) {
+        printf("  io_uring_enter calls: %lu\n", atomic_load(&aio_stats.enters));
+    }
+}
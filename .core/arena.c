@@ -0,0 +1,185 @@
+/*
+
+    OneCoreAI - Run Arenas
+
+    Bump allocator for everything a training run needs (the dataset now,
+    later fold indices, batch buffers and per-thread partial sums). Each
+    thread keeps one arena mapped for its runs: a run reserves what it
+    needs up front, allocations are a pointer bump, and the whole run is
+    released in O(1) by resetting the arena. The mapping is backed by
+    huge pages (MAP_HUGETLB, else transparent huge pages via madvise)
+    where the system has them, and is only replaced when a run needs more.
+
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "handle.h"
+
+#define ARENA_ALIGN 64
+#define ARENA_HUGE_PAGE (2u << 20)
+
+static struct {
+    pthread_mutex_t lock;
+    unsigned long runs;
+    unsigned long maps;           // Arena mappings created (first run or growth)
+    unsigned long huge_maps;      // ... of which backed by MAP_HUGETLB
+    unsigned long fallbacks;      // Runs that fell back to malloc
+    size_t mapped;                // Bytes currently mapped by all arenas
+    size_t peak_run;              // Largest single run
+    size_t in_use;                // Bytes reserved by runs in progress
+    size_t peak_in_use;           // Largest total across concurrent runs
+} arena_stats = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static pthread_key_t run_arena_key;
+static pthread_once_t run_arena_once = PTHREAD_ONCE_INIT;
+
+static size_t arena_round(size_t size, size_t align) {
+    return (size + align - 1) & ~(align - 1);
+}
+
+// Map `capacity` bytes for an arena, preferring huge pages
+int arena_init(Arena *arena, size_t capacity) {
+    memset(arena, 0, sizeof(*arena));
+    capacity = arena_round(capacity > 0 ? capacity : ARENA_ALIGN, 4096);
+
+    void *base = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (capacity >= ARENA_HUGE_PAGE) {
+        size_t huge_capacity = arena_round(capacity, ARENA_HUGE_PAGE);
+        base = mmap(NULL, huge_capacity, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED) {
+            capacity = huge_capacity;
+            arena->huge = 1;
+        }
+    }
+#endif
+    if (base == MAP_FAILED) {
+        base = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            return -1;
+        }
+#ifdef MADV_HUGEPAGE
+        if (capacity >= ARENA_HUGE_PAGE) {
+            madvise(base, capacity, MADV_HUGEPAGE);
+        }
+#endif
+    }
+
+    arena->base = base;
+    arena->capacity = capacity;
+
+    pthread_mutex_lock(&arena_stats.lock);
+    arena_stats.maps++;
+    if (arena->huge) arena_stats.huge_maps++;
+    arena_stats.mapped += capacity;
+    pthread_mutex_unlock(&arena_stats.lock);
+    return 0;
+}
+
+void arena_destroy(Arena *arena) {
+    if (arena->base) {
+        munmap(arena->base, arena->capacity);
+        pthread_mutex_lock(&arena_stats.lock);
+        arena_stats.mapped -= arena->capacity;
+        pthread_mutex_unlock(&arena_stats.lock);
+    }
+    memset(arena, 0, sizeof(*arena));
+}
+
+// Cache-line aligned bump allocation. Returns NULL when the arena is full.
+void *arena_alloc(Arena *arena, size_t size) {
+    size_t offset = arena_round(arena->used, ARENA_ALIGN);
+    if (offset > arena->capacity || size > arena->capacity - offset) {
+        return NULL;
+    }
+    arena->used = offset + size;
+    if (arena->used > arena->peak) arena->peak = arena->used;
+    return arena->base + offset;
+}
+
+// Release every allocation at once
+void arena_reset(Arena *arena) {
+    arena->used = 0;
+}
+
+// Bytes arena_alloc needs for `size` bytes
+size_t arena_size(size_t size) {
+    return arena_round(size, ARENA_ALIGN);
+}
+
+static void run_arena_free(void *arg) {
+    Arena *arena = arg;
+    arena_destroy(arena);
+    free(arena);
+}
+
+static void run_arena_key_init() {
+    pthread_key_create(&run_arena_key, run_arena_free);
+}
+
+// Start a run that needs up to `bytes`: returns this thread's arena, empty
+// and large enough, or NULL (callers then fall back to malloc)
+Arena *arena_run_begin(size_t bytes) {
+    pthread_once(&run_arena_once, run_arena_key_init);
+
+    Arena *arena = pthread_getspecific(run_arena_key);
+    if (!arena) {
+        arena = calloc(1, sizeof(Arena));
+        if (!arena || pthread_setspecific(run_arena_key, arena) != 0) {
+            free(arena);
+            arena = NULL;
+        }
+    }
+    if (arena && arena->capacity < bytes) {
+        arena_destroy(arena);
+        if (arena_init(arena, bytes) != 0) {
+            arena = NULL;
+        }
+    }
+
+    pthread_mutex_lock(&arena_stats.lock);
+    arena_stats.runs++;
+    if (arena) {
+        arena_stats.in_use += bytes;
+        if (arena_stats.in_use > arena_stats.peak_in_use) arena_stats.peak_in_use = arena_stats.in_use;
+    } else {
+        arena_stats.fallbacks++;
+    }
+    pthread_mutex_unlock(&arena_stats.lock);
+
+    if (arena) {
+        arena_reset(arena);
+        arena->reserved = bytes;
+    }
+    return arena;
+}
+
+// Record the run's usage and release everything it allocated
+void arena_run_end(Arena *arena) {
+    if (!arena) {
+        return;
+    }
+    pthread_mutex_lock(&arena_stats.lock);
+    if (arena->used > arena_stats.peak_run) arena_stats.peak_run = arena->used;
+    arena_stats.in_use -= arena->reserved;
+    pthread_mutex_unlock(&arena_stats.lock);
+    arena->reserved = 0;
+    arena_reset(arena);
+}
+
+void arena_report() {
+    pthread_mutex_lock(&arena_stats.lock);
+    printf("Run arenas:\n");
+    printf("  Runs: %lu (%lu fell back to malloc)\n", arena_stats.runs, arena_stats.fallbacks);
+    printf("  Mapped: %.2f MB in %lu mapping(s), %lu on MAP_HUGETLB pages\n",
+           arena_stats.mapped / 1e6, arena_stats.maps, arena_stats.huge_maps);
+    printf("  Peak single run: %.2f MB, peak across concurrent runs: %.2f MB\n",
+           arena_stats.peak_run / 1e6, arena_stats.peak_in_use / 1e6);
+    pthread_mutex_unlock(&arena_stats.lock);
+}
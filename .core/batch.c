@@ -0,0 +1,287 @@
+/*
+
+    OneCoreAI - Script Mode
+
+    Runs commands from a file or stdin without prompts. With more than one
+    job, consecutive commands that touch distinct cores are grouped and run
+    concurrently on a small worker pool; any other command is a barrier.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "handle.h"
+#include "repl.h"
+
+#define BATCH_GROUP_MAX 256
+
+typedef struct {
+    char line[MAX_COMMAND_LINE];
+    char *argv[MAX_COMMAND_ARGS];
+    int argc;
+    int line_no;
+    int too_long;               // Line did not fit in `line`; fails without running
+    int result;
+} BatchCommand;
+
+typedef struct {
+    OneCoreCtx *ctx;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    BatchCommand *group;
+    int group_size;
+    int next;          // Next command in the group to claim
+    int pending;       // Commands claimed or waiting, group is done at 0
+    unsigned generation;
+    int shutdown;
+} BatchPool;
+
+// Collect the core IDs a command touches. Returns the count, or -1 when the
+// command has global effects (create, delete, run, clear, status, ...).
+static int batch_command_cores(const BatchCommand *cmd, int *ids) {
+    static const char *single_core[] = {
+        "predict", "learn", "fetch", "setloss", "setreg", "config", "size", "location", "stream"
+    };
+    const char *name = cmd->argv[0];
+
+    // A background job returns at once; it is ordered like a global command
+    if (strcmp(cmd->argv[cmd->argc - 1], "&") == 0) {
+        return -1;
+    }
+
+    if (strcmp(name, "train") == 0) {
+        int count = 0;
+        for (int i = 1; i < cmd->argc && count < MAX_CORES; i++) {
+            ids[count++] = atoi(cmd->argv[i]);
+        }
+        return count > 0 ? count : -1;
+    }
+    for (size_t i = 0; i < sizeof(single_core) / sizeof(single_core[0]); i++) {
+        if (strcmp(name, single_core[i]) == 0 && cmd->argc >= 2) {
+            ids[0] = atoi(cmd->argv[1]);
+            return 1;
+        }
+    }
+    return -1;
+}
+
+static void batch_execute(OneCoreCtx *ctx, BatchCommand *cmd) {
+    if (cmd->too_long) {
+        fprintf(stderr, "line %d: longer than %d characters, not run\n", cmd->line_no, MAX_COMMAND_LINE - 1);
+        cmd->result = -1;
+        return;
+    }
+    cmd->result = run_command(ctx, cmd->argc, cmd->argv);
+    if (cmd->result != 0) {
+        fprintf(stderr, "line %d: command failed: %s\n", cmd->line_no, cmd->argv[0]);
+    }
+}
+
+// Claim and run commands from the current group until none are left
+static void batch_drain(BatchPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->next < pool->group_size) {
+        BatchCommand *cmd = &pool->group[pool->next++];
+        pthread_mutex_unlock(&pool->lock);
+
+        batch_execute(pool->ctx, cmd);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void *batch_worker(void *arg) {
+    BatchPool *pool = arg;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->shutdown) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        batch_drain(pool);
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// Run a group on the pool (the calling thread helps). Returns failures.
+static int batch_run_group(BatchPool *pool, BatchCommand *group, int size) {
+    if (size == 1) {
+        batch_execute(pool->ctx, &group[0]);
+        return group[0].result != 0;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->group = group;
+    pool->group_size = size;
+    pool->next = 0;
+    pool->pending = size;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    batch_drain(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    int failures = 0;
+    for (int i = 0; i < size; i++) {
+        if (group[i].result != 0) failures++;
+    }
+    return failures;
+}
+
+// Did fgets read a whole line? If not, skip the rest of it and return 0.
+// The last line of the input may lack a newline.
+static int batch_line_complete(char *line, FILE *input) {
+    size_t len = strlen(line);
+    if (len + 1 < MAX_COMMAND_LINE || line[len - 1] == '\n') {
+        return 1;
+    }
+    int c = fgetc(input);
+    if (c == EOF || c == '\n') {
+        return 1;
+    }
+    while (c != EOF && c != '\n') {
+        c = fgetc(input);
+    }
+    return 0;
+}
+
+// Run commands from input. Returns the number of failed commands.
+int batch_run(OneCoreCtx *ctx, FILE *input, int jobs, int stop_on_error) {
+    int group_max = jobs > 1 ? BATCH_GROUP_MAX : 1;
+    BatchCommand *group = malloc(group_max * sizeof(BatchCommand));
+    if (!group) {
+        fprintf(stderr, "Failed to allocate command buffer.\n");
+        return 1;
+    }
+
+    BatchPool pool;
+    memset(&pool, 0, sizeof(pool));
+    pool.ctx = ctx;
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.work_ready, NULL);
+    pthread_cond_init(&pool.work_done, NULL);
+
+    int workers = 0;
+    pthread_t *threads = NULL;
+    if (jobs > 1) {
+        threads = malloc((jobs - 1) * sizeof(pthread_t));
+        for (int i = 0; threads && i < jobs - 1; i++) {
+            if (pthread_create(&threads[i], NULL, batch_worker, &pool) != 0) break;
+            workers++;
+        }
+    }
+
+    // Cores touched by the group being collected (index 0 unused)
+    unsigned char touched[MAX_CORES + 1];
+    memset(touched, 0, sizeof(touched));
+
+    int failures = 0;
+    int size = 0;
+    int line_no = 0;
+    int done = 0;
+
+    while (!done) {
+        BatchCommand *cmd = &group[size];
+        int at_eof = fgets(cmd->line, sizeof(cmd->line), input) == NULL;
+        int ids[MAX_CORES];
+        int id_count = -1;
+
+        if (!at_eof) {
+            line_no++;
+            cmd->line_no = line_no;
+            // A line too long for the buffer fails as a whole (a global
+            // command, so it runs alone); its pieces never run
+            cmd->too_long = !batch_line_complete(cmd->line, input);
+            cmd->argc = 0;
+            if (!cmd->too_long) {
+                cmd->argc = parse_command(cmd->line, cmd->argv, MAX_COMMAND_ARGS);
+                if (cmd->argc == 0 || cmd->argv[0][0] == '#') continue;
+                if (strcmp(cmd->argv[0], "exit") == 0 || strcmp(cmd->argv[0], "quit") == 0) {
+                    at_eof = 1;
+                } else {
+                    id_count = batch_command_cores(cmd, ids);
+                }
+            }
+        }
+
+        // A command joins the open group only if its cores are all untouched
+        int joins = !at_eof && id_count > 0 && size + 1 < group_max;
+        for (int i = 0; joins && i < id_count; i++) {
+            if (ids[i] < 1 || ids[i] > MAX_CORES || touched[ids[i]]) joins = 0;
+        }
+
+        if (joins) {
+            for (int i = 0; i < id_count; i++) touched[ids[i]] = 1;
+            size++;
+            continue;
+        }
+
+        // Flush the open group, then start a new one with this command
+        if (size > 0) {
+            BatchCommand last = {0};
+            if (!at_eof) {
+                last = *cmd;
+            }
+            failures += batch_run_group(&pool, group, size);
+            memset(touched, 0, sizeof(touched));
+            size = 0;
+            if (!at_eof) {
+                group[0] = last;
+                for (int i = 0; i < last.argc; i++) {
+                    group[0].argv[i] = group[0].line + (last.argv[i] - cmd->line);
+                }
+                cmd = &group[0];
+            }
+        }
+        if (stop_on_error && failures > 0) break;
+        if (at_eof) break;
+
+        if (id_count > 0 && group_max > 1) {
+            // Core-scoped command starts the next group
+            for (int i = 0; i < id_count; i++) {
+                if (ids[i] >= 1 && ids[i] <= MAX_CORES) touched[ids[i]] = 1;
+            }
+            size = 1;
+        } else {
+            // Global command runs on its own
+            batch_execute(ctx, cmd);
+            if (cmd->result != 0) failures++;
+        }
+        if (stop_on_error && failures > 0) done = 1;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.shutdown = 1;
+    pthread_cond_broadcast(&pool.work_ready);
+    pthread_mutex_unlock(&pool.lock);
+    for (int i = 0; i < workers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool.work_done);
+    pthread_cond_destroy(&pool.work_ready);
+    pthread_mutex_destroy(&pool.lock);
+    free(threads);
+    free(group);
+    fflush(stdout);
+    return failures;
+}
@@ -0,0 +1,343 @@
+/*
+
+    OneCoreAI - Background Checkpointing
+
+    Training hands a copy of the core to this module every N epochs and/or
+    seconds. The copy goes into a per-core pending slot (a newer checkpoint
+    replaces one that hasn't been written yet) and a background thread does
+    the file I/O, fsync and atomic rename, so the training loop only pays
+    for one small memcpy. Everything pending when the writer wakes is
+    written as one batch: each checkpoint is formatted in memory, and the
+    writes and fsyncs for all files go out together through aio.c, with a
+    single directory fsync for all the renames.
+
+    Checkpoints are file-per-core-ID, so one context at a time checkpoints:
+    the one that enabled it.
+
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "handle.h"
+#include "context.h"
+#include "trace.h"
+
+typedef struct {
+    AICore core;         // Copy of the core at the end of `epoch`
+    int epoch;
+    int pending;
+} CheckpointSlot;
+
+// Settings and slots are guarded by lock; enabled may also be read without
+// it, so epochs skip the lock while checkpointing is off
+static struct {
+    _Atomic int enabled;
+    OneCoreCtx *ctx;          // Context whose cores are checkpointed
+    int every_epochs;
+    double every_seconds;
+    char dir[256];
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    pthread_t thread;
+    int running;
+    int stopping;
+    int writing;
+    CheckpointSlot slots[MAX_CORES];
+    double last_time[MAX_CORES];
+
+    unsigned long written;
+    unsigned long replaced;   // Checkpoints superseded before being written
+    unsigned long failed;
+    unsigned long batches;
+} ckpt = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .idle = PTHREAD_COND_INITIALIZER
+};
+
+static double checkpoint_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Checkpoint file for a core
+void checkpoint_path(int core_id, char *path, size_t size) {
+    snprintf(path, size, "%s/core_%d.ckpt", ckpt.dir[0] ? ckpt.dir : ".", core_id);
+}
+
+typedef struct {
+    char path[512];
+    char tmp[520];
+    char *text;          // Formatted checkpoint
+    size_t length;
+    int fd;
+} CheckpointFile;
+
+// Format a checkpoint in memory and open its temporary file
+static int checkpoint_prepare(const CheckpointSlot *slot, CheckpointFile *file) {
+    checkpoint_path(slot->core.id, file->path, sizeof(file->path));
+    snprintf(file->tmp, sizeof(file->tmp), "%s.tmp", file->path);
+    file->text = NULL;
+    file->length = 0;
+    file->fd = -1;
+
+    FILE *stream = open_memstream(&file->text, &file->length);
+    if (!stream) {
+        return -1;
+    }
+    int result = ai_block_write_variables(stream, &slot->core, slot->epoch);
+    if (fclose(stream) != 0 || result != 0) {
+        free(file->text);
+        file->text = NULL;
+        return -1;
+    }
+
+    file->fd = open(file->tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file->fd < 0) {
+        free(file->text);
+        file->text = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// Write checkpoints to temporary files, fsync them, then rename each over
+// the old one. Returns how many were written.
+static int checkpoint_write_batch(const CheckpointSlot *slots, int count) {
+    CheckpointFile files[MAX_CORES];
+    AioOp ops[2 * MAX_CORES];
+    int prepared[MAX_CORES];
+    int op_count = 0;
+
+    // One write -> fsync chain per file, all submitted together
+    for (int i = 0; i < count; i++) {
+        prepared[i] = checkpoint_prepare(&slots[i], &files[i]) == 0;
+        if (!prepared[i]) continue;
+        ops[op_count++] = (AioOp){ .opcode = AIO_WRITE, .fd = files[i].fd, .buf = files[i].text,
+                                   .len = files[i].length, .offset = 0, .link = 1 };
+        ops[op_count++] = (AioOp){ .opcode = AIO_FSYNC, .fd = files[i].fd };
+    }
+    aio_submit(ops, op_count);
+
+    int written = 0;
+    for (int i = 0, op = 0; i < count; i++) {
+        if (!prepared[i]) continue;
+        // Wait for both ops: a cancelled fsync still completes
+        ssize_t wrote = aio_wait(&ops[op]);
+        ssize_t synced = aio_wait(&ops[op + 1]);
+        int ok = wrote == (ssize_t)files[i].length && synced == 0;
+        op += 2;
+
+        if (close(files[i].fd) != 0) ok = 0;
+        free(files[i].text);
+        if (ok && rename(files[i].tmp, files[i].path) == 0) {
+            written++;
+        } else {
+            unlink(files[i].tmp);
+        }
+    }
+
+    // Make the renames themselves durable
+    if (written > 0) {
+        int dir_fd = open(ckpt.dir[0] ? ckpt.dir : ".", O_RDONLY | O_DIRECTORY);
+        if (dir_fd >= 0) {
+            fsync(dir_fd);
+            close(dir_fd);
+        }
+    }
+    return written;
+}
+
+static void *checkpoint_writer(void *arg) {
+    (void)arg;
+    static CheckpointSlot batch[MAX_CORES];
+    trace_name_thread("checkpoint writer");
+
+    pthread_mutex_lock(&ckpt.lock);
+    while (1) {
+        int count = 0;
+        for (int i = 0; i < MAX_CORES; i++) {
+            if (ckpt.slots[i].pending) {
+                batch[count++] = ckpt.slots[i];
+                ckpt.slots[i].pending = 0;
+            }
+        }
+
+        if (count == 0) {
+            ckpt.writing = 0;
+            pthread_cond_broadcast(&ckpt.idle);
+            if (ckpt.stopping) break;
+            pthread_cond_wait(&ckpt.wake, &ckpt.lock);
+            continue;
+        }
+
+        // Take every pending slot and do the I/O without holding the lock
+        ckpt.writing = 1;
+        pthread_mutex_unlock(&ckpt.lock);
+
+        TRACE_BEGIN(TRACE_CHECKPOINT, -1, count);
+        int written = checkpoint_write_batch(batch, count);
+        TRACE_END(TRACE_CHECKPOINT, -1, count);
+
+        pthread_mutex_lock(&ckpt.lock);
+        ckpt.written += written;
+        ckpt.failed += count - written;
+        ckpt.batches++;
+    }
+    pthread_mutex_unlock(&ckpt.lock);
+    return NULL;
+}
+
+// Wait until every pending checkpoint is on disk
+void checkpoint_flush() {
+    pthread_mutex_lock(&ckpt.lock);
+    while (ckpt.running) {
+        int pending = ckpt.writing;
+        for (int i = 0; i < MAX_CORES && !pending; i++) {
+            pending = ckpt.slots[i].pending;
+        }
+        if (!pending) break;
+        pthread_cond_wait(&ckpt.idle, &ckpt.lock);
+    }
+    pthread_mutex_unlock(&ckpt.lock);
+}
+
+// Flush and stop the writer thread
+static void checkpoint_shutdown() {
+    pthread_mutex_lock(&ckpt.lock);
+    if (!ckpt.running) {
+        pthread_mutex_unlock(&ckpt.lock);
+        return;
+    }
+    ckpt.enabled = 0;
+    ckpt.ctx = NULL;
+    ckpt.stopping = 1;
+    pthread_cond_signal(&ckpt.wake);
+    pthread_mutex_unlock(&ckpt.lock);
+
+    pthread_join(ckpt.thread, NULL);
+    ckpt.running = 0;
+    ckpt.stopping = 0;
+}
+
+// Enable checkpoints of ctx's cores every `epochs` epochs and/or `seconds` seconds into dir
+int checkpoint_enable(OneCoreCtx *ctx, int epochs, double seconds, const char *dir) {
+    if (epochs <= 0 && seconds <= 0) {
+        printf("Checkpoint interval must be positive.\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&ckpt.lock);
+    if (ckpt.enabled && ckpt.ctx != ctx) {
+        pthread_mutex_unlock(&ckpt.lock);
+        printf("Another context is checkpointing.\n");
+        return -1;
+    }
+    ckpt.ctx = ctx;
+    ckpt.every_epochs = epochs > 0 ? epochs : 0;
+    ckpt.every_seconds = seconds > 0 ? seconds : 0;
+    snprintf(ckpt.dir, sizeof(ckpt.dir), "%s", dir && dir[0] ? dir : ".");
+    double now = checkpoint_now();
+    for (int i = 0; i < MAX_CORES; i++) {
+        ckpt.last_time[i] = now;
+    }
+
+    if (!ckpt.running) {
+        if (pthread_create(&ckpt.thread, NULL, checkpoint_writer, NULL) != 0) {
+            pthread_mutex_unlock(&ckpt.lock);
+            printf("Failed to start checkpoint writer.\n");
+            return -1;
+        }
+        ckpt.running = 1;
+
+        static int exit_registered = 0;
+        if (!exit_registered) {
+            atexit(checkpoint_shutdown);
+            exit_registered = 1;
+        }
+    }
+    ckpt.enabled = 1;
+    pthread_mutex_unlock(&ckpt.lock);
+
+    printf("Checkpointing to %s/core_<id>.ckpt every", ckpt.dir);
+    if (epochs > 0) printf(" %d epochs", epochs);
+    if (epochs > 0 && seconds > 0) printf(" or");
+    if (seconds > 0) printf(" %.1f seconds", seconds);
+    printf("\n");
+    return 0;
+}
+
+void checkpoint_disable() {
+    checkpoint_shutdown();
+    printf("Checkpointing disabled (%lu written).\n", ckpt.written);
+}
+
+// Flush and stop checkpointing if ctx enabled it (the context is going away)
+void checkpoint_release(OneCoreCtx *ctx) {
+    pthread_mutex_lock(&ckpt.lock);
+    int owner = ckpt.ctx == ctx;
+    pthread_mutex_unlock(&ckpt.lock);
+    if (owner) {
+        checkpoint_shutdown();
+    }
+}
+
+void checkpoint_status() {
+    pthread_mutex_lock(&ckpt.lock);
+    printf("Checkpointing: %s\n", ckpt.enabled ? "enabled" : "disabled");
+    if (ckpt.enabled) {
+        printf("  Directory: %s\n", ckpt.dir);
+        if (ckpt.every_epochs > 0) printf("  Every %d epochs\n", ckpt.every_epochs);
+        if (ckpt.every_seconds > 0) printf("  Every %.1f seconds\n", ckpt.every_seconds);
+    }
+    printf("  Written: %lu in %lu batch(es), Superseded: %lu, Failed: %lu\n",
+           ckpt.written, ckpt.batches, ckpt.replaced, ckpt.failed);
+    pthread_mutex_unlock(&ckpt.lock);
+}
+
+// Called by the training loop after each epoch; `epoch` epochs are complete.
+// Checkpoint files hold linear parameters, so MLP cores are not checkpointed.
+void checkpoint_after_epoch(OneCoreCtx *ctx, const AICore *core, int epoch) {
+    if (core->type != CORE_LINEAR || core->id < 1 || core->id > MAX_CORES) {
+        return;
+    }
+    if (!atomic_load_explicit(&ckpt.enabled, memory_order_relaxed)) {
+        return;
+    }
+
+    // checkpoint_enable may change the settings or the context meanwhile
+    int slot_index = core->id - 1;
+    pthread_mutex_lock(&ckpt.lock);
+    int due = 0;
+    double now = 0.0;
+    if (ckpt.enabled && ckpt.ctx == ctx) {
+        due = ckpt.every_epochs > 0 && epoch % ckpt.every_epochs == 0;
+        if (!due && ckpt.every_seconds > 0) {
+            now = checkpoint_now();
+            due = now - ckpt.last_time[slot_index] >= ckpt.every_seconds;
+        }
+    }
+    if (!due) {
+        pthread_mutex_unlock(&ckpt.lock);
+        return;
+    }
+
+    CheckpointSlot *slot = &ckpt.slots[slot_index];
+    if (slot->pending) ckpt.replaced++;
+    slot->core = *core;
+    slot->epoch = epoch;
+    slot->pending = 1;
+    ckpt.last_time[slot_index] = now > 0.0 ? now : checkpoint_now();
+    pthread_cond_signal(&ckpt.wake);
+    pthread_mutex_unlock(&ckpt.lock);
+}
@@ -0,0 +1,108 @@
+/*
+
+    OneCoreAI - Engine Context
+
+    Everything one engine instance owns: its cores and their locks, the
+    data sheets of its last training run, the generator and dataset
+    settings, the parallel training placement and last run, the per-core
+    memory counters, the published parameter copies and the background
+    job table. Library users only see the opaque
+    OneCoreCtx from handle.h; engine files include this header.
+
+    Contexts share nothing, so independent contexts run on different
+    threads without contending on a lock. The structure is cache-line
+    aligned and each core lock sits on its own line.
+
+*/
+
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "handle.h"
+#include "onecore_shm.h"
+
+#define CTX_CACHE_LINE 64
+
+// Data sheets kept from the most recent training run ('hexlist')
+#define MAX_HEX_DATA 1000
+
+// Background jobs remembered per context (finished ones are reused oldest first)
+#define MAX_JOBS 64
+
+// NUMA nodes tracked by parallel training (numa.c)
+#define NUMA_MAX_NODES 16
+
+typedef struct {
+    pthread_mutex_t lock;
+} __attribute__((aligned(CTX_CACHE_LINE))) CoreLock;
+
+// Per-node results of a parallel training run (see numa.c)
+typedef struct {
+    int workers;
+    int cores;
+    double bytes;               // Dataset bytes streamed by training
+    double seconds;             // Longest worker on the node
+} NumaNodeStats;
+
+// One background training job (see jobs.c)
+typedef struct {
+    int id;                     // 0: slot unused
+    OneCoreCtx *ctx;
+    JobKind kind;
+    _Atomic int state;          // JobState
+    int core_ids[MAX_CORES];
+    int core_count;
+    char filename[256];         // Checkpoint to resume from
+    long total_epochs;
+    int result;
+    double started;
+    double seconds;
+    int waited;                 // Result already reported by job_wait
+    TrainControl control;
+} Job;
+
+struct OneCoreCtx {
+    AICore cores[MAX_CORES];
+    int active_cores;
+
+    // Per-core locks serialize writers (training, learning) of the same core
+    CoreLock core_locks[MAX_CORES];
+
+    // Hex data of the most recent training run
+    pthread_mutex_t hex_data_lock;
+    unsigned char recent_hex_data[MAX_HEX_DATA];
+    int recent_hex_count;
+
+    // Storage precision and source of generated training data
+    DataPrecision dataset_precision;
+    GeneratorConfig generator;
+
+    // Parallel training placement and worker count (0: one per CPU), and
+    // the per-node results of the last run (numa.c)
+    NumaPolicy numa_policy;
+    int numa_workers;
+    pthread_mutex_t numa_stats_lock;
+    NumaNodeStats numa_last_run[NUMA_MAX_NODES];
+    int numa_last_run_valid;
+
+    // Interactive sessions redraw the core visualization; embedded and script use stays quiet
+    int interactive;
+
+    // Dataset each core is training on now, or trained on last (memory.c)
+    _Atomic size_t core_dataset[MAX_CORES];
+    _Atomic size_t core_dataset_last[MAX_CORES];
+
+    // Parameters as of each core's last publish, read while it trains (snapshot.c)
+    OneCoreShmEntry published[MAX_CORES];
+
+    // Background jobs (jobs.c)
+    pthread_mutex_t job_lock;
+    pthread_cond_t job_done;
+    Job jobs[MAX_JOBS];
+    int next_job_id;
+    int jobs_active;
+} __attribute__((aligned(CTX_CACHE_LINE)));
+
+#endif
@@ -0,0 +1,648 @@
+/*
+
+    OneCoreAI - Dataset Storage
+
+    Column-oriented training data. The x and y columns are stored as fp32,
+    or as fp16/bf16 to halve memory traffic; half columns are converted back
+    to fp32 a chunk at a time (F16C/AVX2 when the CPU has them) into a small
+    buffer that stays in L1 while the training loop consumes it. Implicit
+    datasets store nothing: their columns are descriptors, computed into
+    the same chunk buffers from the sample index (generator.c). Dataset
+    files are read with O_DIRECT through aio.c, several buffers ahead of
+    the parser.
+
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "handle.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DATASET_HAVE_X86 1
+#endif
+
+static const char *precision_names[] = { "fp32", "fp16", "bf16" };
+
+const char *dataset_precision_name(DataPrecision precision) {
+    return precision >= PRECISION_FP32 && precision <= PRECISION_BF16 ? precision_names[precision] : "?";
+}
+
+// Parse "fp32", "fp16" or "bf16". Returns -1 if unknown.
+int dataset_parse_precision(const char *name, DataPrecision *precision) {
+    for (int i = PRECISION_FP32; i <= PRECISION_BF16; i++) {
+        if (strcmp(name, precision_names[i]) == 0) {
+            *precision = (DataPrecision)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Scalar conversions
+
+static uint32_t float_bits(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static float bits_float(uint32_t u) {
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// IEEE half precision, round to nearest even
+static uint16_t fp32_to_fp16(float f) {
+    uint32_t u = float_bits(f);
+    uint32_t sign = (u >> 16) & 0x8000;
+    int32_t exp = (int32_t)((u >> 23) & 0xFF) - 127 + 15;
+    uint32_t mant = u & 0x7FFFFF;
+
+    if (((u >> 23) & 0xFF) == 0xFF) {                  // Inf / NaN
+        return sign | 0x7C00 | (mant ? 0x200 : 0);
+    }
+    if (exp >= 31) {                                     // Overflow
+        return sign | 0x7C00;
+    }
+    if (exp <= 0) {                                      // Subnormal or zero
+        if (exp < -10) return sign;
+        mant |= 0x800000;
+        uint32_t shift = 14 - exp;
+        uint32_t half = mant >> shift;
+        uint32_t rem = mant & ((1u << shift) - 1);
+        uint32_t midpoint = 1u << (shift - 1);
+        if (rem > midpoint || (rem == midpoint && (half & 1))) half++;
+        return sign | half;
+    }
+
+    uint32_t half = sign | (exp << 10) | (mant >> 13);
+    uint32_t rem = mant & 0x1FFF;
+    if (rem > 0x1000 || (rem == 0x1000 && (half & 1))) half++;  // May carry into exponent
+    return (uint16_t)half;
+}
+
+static float fp16_to_fp32(uint16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1F;
+    uint32_t mant = h & 0x3FF;
+
+    if (exp == 0) {
+        if (mant == 0) return bits_float(sign);
+        // Subnormal: normalize
+        exp = 127 - 15 + 1;
+        while (!(mant & 0x400)) {
+            mant <<= 1;
+            exp--;
+        }
+        mant &= 0x3FF;
+        return bits_float(sign | (exp << 23) | (mant << 13));
+    }
+    if (exp == 31) {
+        return bits_float(sign | 0x7F800000 | (mant << 13));
+    }
+    return bits_float(sign | ((exp - 15 + 127) << 23) | (mant << 13));
+}
+
+// bfloat16: the top half of an fp32, round to nearest even
+static uint16_t fp32_to_bf16(float f) {
+    uint32_t u = float_bits(f);
+    if ((u & 0x7FFFFFFF) > 0x7F800000) {
+        return (uint16_t)((u >> 16) | 0x40);             // Keep NaN quiet
+    }
+    u += 0x7FFF + ((u >> 16) & 1);
+    return (uint16_t)(u >> 16);
+}
+
+static float bf16_to_fp32(uint16_t h) {
+    return bits_float((uint32_t)h << 16);
+}
+
+// Vector conversions (F16C / AVX2), selected once at runtime
+
+#ifdef DATASET_HAVE_X86
+__attribute__((target("f16c,avx")))
+static size_t fp16_to_fp32_f16c(const uint16_t *in, float *out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm_loadu_si128((const __m128i *)(in + i));
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(h));
+    }
+    return i;
+}
+
+__attribute__((target("f16c,avx")))
+static size_t fp32_to_fp16_f16c(const float *in, uint16_t *out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i *)(out + i), h);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t bf16_to_fp32_avx2(const uint16_t *in, float *out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i w = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(in + i)));
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_slli_epi32(w, 16));
+    }
+    return i;
+}
+#endif
+
+static int dataset_has_f16c() {
+#ifdef DATASET_HAVE_X86
+    static int cached = -1;
+    if (cached < 0) cached = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    return cached;
+#else
+    return 0;
+#endif
+}
+
+static int dataset_has_avx2() {
+#ifdef DATASET_HAVE_X86
+    static int cached = -1;
+    if (cached < 0) cached = __builtin_cpu_supports("avx2");
+    return cached;
+#else
+    return 0;
+#endif
+}
+
+// Decode a half column into fp32
+static void half_to_float(DataPrecision precision, const uint16_t *in, float *out, size_t count) {
+    size_t i = 0;
+    if (precision == PRECISION_FP16) {
+#ifdef DATASET_HAVE_X86
+        if (dataset_has_f16c()) i = fp16_to_fp32_f16c(in, out, count);
+#endif
+        for (; i < count; i++) out[i] = fp16_to_fp32(in[i]);
+    } else {
+#ifdef DATASET_HAVE_X86
+        if (dataset_has_avx2()) i = bf16_to_fp32_avx2(in, out, count);
+#endif
+        for (; i < count; i++) out[i] = bf16_to_fp32(in[i]);
+    }
+}
+
+// Encode fp32 values into a half column
+static void float_to_half(DataPrecision precision, const float *in, uint16_t *out, size_t count) {
+    size_t i = 0;
+    if (precision == PRECISION_FP16) {
+#ifdef DATASET_HAVE_X86
+        if (dataset_has_f16c()) i = fp32_to_fp16_f16c(in, out, count);
+#endif
+        for (; i < count; i++) out[i] = fp32_to_fp16(in[i]);
+    } else {
+        for (; i < count; i++) out[i] = fp32_to_bf16(in[i]);
+    }
+}
+
+// Dataset management
+
+int dataset_alloc(Dataset *data, size_t size, DataPrecision precision) {
+    return dataset_alloc_in(data, size, precision, NULL);
+}
+
+// Allocate the columns from an arena (released with the arena) or, with
+// a NULL arena, from the heap
+int dataset_alloc_in(Dataset *data, size_t size, DataPrecision precision, Arena *arena) {
+    memset(data, 0, sizeof(*data));
+    data->size = size;
+    data->precision = precision;
+    data->arena = arena;
+
+    size_t elem = precision == PRECISION_FP32 ? sizeof(float) : sizeof(uint16_t);
+    if (arena) {
+        data->x = arena_alloc(arena, size * elem);
+        data->y = arena_alloc(arena, size * elem);
+        data->data_sheet = arena_alloc(arena, size);
+    } else {
+        data->x = malloc(size * elem);
+        data->y = malloc(size * elem);
+        data->data_sheet = malloc(size);
+    }
+    if (!data->x || !data->y || !data->data_sheet) {
+        dataset_free(data);
+        return -1;
+    }
+    memory_dataset_alloc(dataset_bytes(data));
+    return 0;
+}
+
+// Arena bytes dataset_alloc_in needs for `size` samples
+size_t dataset_arena_size(size_t size, DataPrecision precision) {
+    size_t elem = precision == PRECISION_FP32 ? sizeof(float) : sizeof(uint16_t);
+    return 2 * arena_size(size * elem) + arena_size(size);
+}
+
+void dataset_free(Dataset *data) {
+    if (data->x && data->y && data->data_sheet) {
+        memory_dataset_free(dataset_bytes(data));
+    }
+    // Arena columns are released when the arena is reset
+    if (!data->arena) {
+        free(data->x);
+        free(data->y);
+        free(data->data_sheet);
+    }
+    memset(data, 0, sizeof(*data));
+}
+
+// Bytes of sample storage held by the dataset
+size_t dataset_bytes(const Dataset *data) {
+    if (dataset_is_implicit(data)) {
+        return 0;
+    }
+    size_t elem = data->precision == PRECISION_FP32 ? sizeof(float) : sizeof(uint16_t);
+    return data->size * (2 * elem + 1);
+}
+
+// Store fp32 samples at [start, start + count), converting to the column precision
+void dataset_set(Dataset *data, size_t start, const float *x, const float *y,
+                 const unsigned char *data_sheet, size_t count) {
+    if (data->precision == PRECISION_FP32) {
+        memcpy((float *)data->x + start, x, count * sizeof(float));
+        memcpy((float *)data->y + start, y, count * sizeof(float));
+    } else {
+        float_to_half(data->precision, x, (uint16_t *)data->x + start, count);
+        float_to_half(data->precision, y, (uint16_t *)data->y + start, count);
+    }
+    if (data_sheet) {
+        memcpy(data->data_sheet + start, data_sheet, count);
+    } else {
+        memset(data->data_sheet + start, 0, count);
+    }
+}
+
+// Build a dataset from array-of-structs training samples
+int dataset_from_training_data(Dataset *data, const TrainingData *samples, size_t size,
+                               DataPrecision precision) {
+    if (dataset_alloc(data, size, precision) != 0) {
+        return -1;
+    }
+
+    float x[DATASET_CHUNK], y[DATASET_CHUNK];
+    unsigned char sheet[DATASET_CHUNK];
+    for (size_t start = 0; start < size; start += DATASET_CHUNK) {
+        size_t count = size - start < DATASET_CHUNK ? size - start : DATASET_CHUNK;
+        for (size_t i = 0; i < count; i++) {
+            x[i] = samples[start + i].x;
+            y[i] = samples[start + i].y;
+            sheet[i] = samples[start + i].data_sheet;
+        }
+        dataset_set(data, start, x, y, sheet, count);
+    }
+    return 0;
+}
+
+// Copy a dataset into another precision
+int dataset_convert(Dataset *out, const Dataset *in, DataPrecision precision) {
+    if (dataset_alloc(out, in->size, precision) != 0) {
+        return -1;
+    }
+    for (size_t start = 0; start < in->size; start += DATASET_CHUNK) {
+        DatasetChunk chunk;
+        size_t count = dataset_chunk(in, start, DATASET_CHUNK, &chunk);
+        dataset_set(out, start, chunk.x, chunk.y, chunk.data_sheet, count);
+    }
+    return 0;
+}
+
+// Copy a dataset as-is into new storage (an arena, or the heap if NULL).
+// An implicit dataset is only its descriptors, so the copy is too.
+int dataset_clone(Dataset *out, const Dataset *in, Arena *arena) {
+    if (dataset_is_implicit(in)) {
+        *out = *in;
+        out->arena = NULL;
+        return 0;
+    }
+    if (dataset_alloc_in(out, in->size, in->precision, arena) != 0) {
+        return -1;
+    }
+    size_t elem = in->precision == PRECISION_FP32 ? sizeof(float) : sizeof(uint16_t);
+    memcpy(out->x, in->x, in->size * elem);
+    memcpy(out->y, in->y, in->size * elem);
+    memcpy(out->data_sheet, in->data_sheet, in->size);
+    return 0;
+}
+
+// Samples [start, start + count) of a dataset, sharing its storage. The
+// view must not be freed and is only valid while `in` is.
+void dataset_view(Dataset *out, const Dataset *in, size_t start, size_t count) {
+    size_t elem = in->precision == PRECISION_FP32 ? sizeof(float) : sizeof(uint16_t);
+    if (start > in->size) start = in->size;
+    if (count > in->size - start) count = in->size - start;
+    *out = *in;
+    out->size = count;
+    out->first = in->first + start;
+    if (dataset_is_implicit(in)) {
+        return;
+    }
+    out->x = (char *)in->x + start * elem;
+    out->y = (char *)in->y + start * elem;
+    out->data_sheet = in->data_sheet + start;
+}
+
+// Datasets are either stored or implicit: every column has storage, or none
+int dataset_is_implicit(const Dataset *data) {
+    return data->x_column.kind != COLUMN_STORED;
+}
+
+// Expose samples [start, start + count) as fp32 arrays. fp32 columns are
+// returned in place; half columns are decoded and implicit ones computed
+// into the chunk's buffers. Returns the number of samples in the chunk.
+size_t dataset_chunk(const Dataset *data, size_t start, size_t count, DatasetChunk *chunk) {
+    if (start >= data->size) return 0;
+    if (count > DATASET_CHUNK) count = DATASET_CHUNK;
+    if (count > data->size - start) count = data->size - start;
+
+    if (dataset_is_implicit(data)) {
+        uint64_t index = data->first + start;
+        generator_column(&data->x_column, index, count, NULL, chunk->x_buf);
+        generator_column(&data->y_column, index, count, chunk->x_buf, chunk->y_buf);
+        generator_column_sheet(&data->sheet_column, index, count, chunk->sheet_buf);
+        chunk->x = chunk->x_buf;
+        chunk->y = chunk->y_buf;
+        chunk->data_sheet = chunk->sheet_buf;
+        return count;
+    }
+
+    chunk->data_sheet = data->data_sheet + start;
+    if (data->precision == PRECISION_FP32) {
+        chunk->x = (const float *)data->x + start;
+        chunk->y = (const float *)data->y + start;
+    } else {
+        half_to_float(data->precision, (const uint16_t *)data->x + start, chunk->x_buf, count);
+        half_to_float(data->precision, (const uint16_t *)data->y + start, chunk->y_buf, count);
+        chunk->x = chunk->x_buf;
+        chunk->y = chunk->y_buf;
+    }
+    return count;
+}
+
+// Read-ahead for dataset files: LOAD_DEPTH buffers of LOAD_BUFFER bytes in flight
+#define LOAD_BUFFER (1u << 20)
+#define LOAD_DEPTH 4
+#define LOAD_ALIGN 4096
+
+typedef struct {
+    float *x;
+    float *y;
+    unsigned char *sheet;
+    size_t size;
+    size_t capacity;
+} LoadColumns;
+
+// Parse one "x y [sheet]" line (commas allowed, '#' comments skipped)
+static int load_line(LoadColumns *cols, char *line) {
+    if (line[0] == '#') {
+        return 0;
+    }
+    for (char *c = line; *c; c++) {
+        if (*c == ',') *c = ' ';
+    }
+    char *end;
+    float xv = strtof(line, &end);
+    if (end == line) return 0;
+    char *next = end;
+    float yv = strtof(next, &end);
+    if (end == next) return 0;
+    unsigned int sv = (unsigned int)strtol(end, NULL, 0);
+
+    if (cols->size == cols->capacity) {
+        size_t capacity = cols->capacity * 2;
+        float *nx = realloc(cols->x, capacity * sizeof(float));
+        if (nx) cols->x = nx;
+        float *ny = realloc(cols->y, capacity * sizeof(float));
+        if (ny) cols->y = ny;
+        unsigned char *ns = realloc(cols->sheet, capacity);
+        if (ns) cols->sheet = ns;
+        if (!nx || !ny || !ns) {
+            return -1;
+        }
+        cols->capacity = capacity;
+    }
+    cols->x[cols->size] = xv;
+    cols->y[cols->size] = yv;
+    cols->sheet[cols->size] = (unsigned char)sv;
+    cols->size++;
+    return 0;
+}
+
+// Queue the read of block `block` into its buffer
+static void load_read(AioOp *op, int fd, void *buf, off_t block) {
+    *op = (AioOp){ .opcode = AIO_READ, .fd = fd, .buf = buf, .len = LOAD_BUFFER,
+                   .offset = block * (off_t)LOAD_BUFFER };
+    aio_submit(op, 1);
+}
+
+// Load "x y [data_sheet]" samples (whitespace or comma separated, '#' comments)
+int dataset_load_file(Dataset *data, const char *filename, DataPrecision precision) {
+    // O_DIRECT skips the page cache copy; not every filesystem allows it
+    int direct = 1;
+    int fd = open(filename, O_RDONLY | O_DIRECT | O_CLOEXEC);
+    if (fd < 0 && errno == EINVAL) {
+        direct = 0;
+        fd = open(filename, O_RDONLY | O_CLOEXEC);
+    }
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+
+    LoadColumns cols = { .capacity = 4096 };
+    cols.x = malloc(cols.capacity * sizeof(float));
+    cols.y = malloc(cols.capacity * sizeof(float));
+    cols.sheet = malloc(cols.capacity);
+    char *buffers[LOAD_DEPTH] = { NULL };
+    int result = cols.x && cols.y && cols.sheet ? 0 : -1;
+    for (int i = 0; i < LOAD_DEPTH && result == 0; i++) {
+        if (posix_memalign((void **)&buffers[i], LOAD_ALIGN, LOAD_BUFFER) != 0) {
+            buffers[i] = NULL;
+            result = -1;
+        }
+    }
+
+    AioOp ops[LOAD_DEPTH];
+    off_t blocks = (st.st_size + LOAD_BUFFER - 1) / LOAD_BUFFER;
+    off_t issued = 0;
+    while (result == 0 && issued < blocks && issued < LOAD_DEPTH) {
+        load_read(&ops[issued], fd, buffers[issued], issued);
+        issued++;
+    }
+
+    // Lines are parsed straight out of the read buffers; a line split
+    // across two buffers is carried over in `line`
+    char line[256];
+    size_t line_length = 0;
+    for (off_t block = 0; block < issued; block++) {
+        int slot = (int)(block % LOAD_DEPTH);
+        ssize_t got = aio_wait(&ops[slot]);
+        if (got == -EINVAL && direct) {
+            // The filesystem refused O_DIRECT for this read: carry on buffered
+            direct = 0;
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+            load_read(&ops[slot], fd, buffers[slot], block);
+            got = aio_wait(&ops[slot]);
+        }
+        if (got < 0) {
+            result = -1;
+        }
+
+        const char *text = buffers[slot];
+        size_t length = result == 0 ? (size_t)got : 0;
+        size_t pos = 0;
+        while (pos < length) {
+            const char *newline = memchr(text + pos, '\n', length - pos);
+            size_t end = newline ? (size_t)(newline - text) : length;
+            size_t take = end - pos;
+            if (take > sizeof(line) - 1 - line_length) take = sizeof(line) - 1 - line_length;
+            memcpy(line + line_length, text + pos, take);
+            line_length += take;
+            pos = end;
+            if (newline) {
+                line[line_length] = '\0';
+                if (load_line(&cols, line) != 0) result = -1;
+                line_length = 0;
+                pos++;
+            }
+        }
+
+        // Buffer consumed: reuse it for the next block
+        if (result == 0 && issued < blocks) {
+            load_read(&ops[issued % LOAD_DEPTH], fd, buffers[issued % LOAD_DEPTH], issued);
+            issued++;
+        }
+        if (result != 0) {
+            // Drain what is still in flight before the buffers go away
+            for (off_t rest = block + 1; rest < issued; rest++) {
+                aio_wait(&ops[rest % LOAD_DEPTH]);
+            }
+            break;
+        }
+    }
+    if (result == 0 && line_length > 0) {
+        line[line_length] = '\0';
+        result = load_line(&cols, line);
+    }
+    close(fd);
+    for (int i = 0; i < LOAD_DEPTH; i++) {
+        free(buffers[i]);
+    }
+
+    if (cols.size == 0) {
+        result = -1;
+    }
+    if (result == 0) {
+        result = dataset_alloc(data, cols.size, precision);
+    }
+    if (result == 0) {
+        dataset_set(data, 0, cols.x, cols.y, cols.sheet, cols.size);
+    }
+
+    free(cols.x);
+    free(cols.y);
+    free(cols.sheet);
+    return result;
+}
+
+// Synthetic samples from the configured generator ('gen')
+static int dataset_synthetic(OneCoreCtx *ctx, Dataset *data, size_t size) {
+    if (dataset_alloc(data, size, PRECISION_FP32) != 0) {
+        return -1;
+    }
+    generator_fill(data, onecore_generator(ctx));
+    return 0;
+}
+
+// Train copies of a core on the same data stored at each precision and
+// report final parameters, loss (evaluated on the fp32 data) and epoch speed.
+// source is a dataset file, a synthetic sample count, or NULL for 1M samples.
+int dataset_compare_precision(OneCoreCtx *ctx, int core_id, const char *source) {
+    AICore *core = core_get(ctx, core_id);
+    if (!core) {
+        printf("Invalid core ID: %d\n", core_id);
+        return -1;
+    }
+
+    if (core->type == CORE_MLP) {
+        printf("Core %d is an MLP core; precision compare runs linear cores.\n", core_id);
+        return -1;
+    }
+
+    Dataset base;
+    char *end = NULL;
+    size_t size = source ? strtoull(source, &end, 10) : 1000000;
+    int loaded = source && (end == source || *end != '\0');
+    if (loaded ? dataset_load_file(&base, source, PRECISION_FP32) != 0
+               : dataset_synthetic(ctx, &base, size) != 0) {
+        printf("Failed to %s dataset %s\n", loaded ? "load" : "generate", source ? source : "");
+        return -1;
+    }
+
+    printf("Precision comparison on %zu %s samples, %d epochs (lr=%.4f)\n", base.size,
+           loaded ? "loaded" : "generated", core->epochs, core->learning_rate);
+    printf("  %-5s %10s %10s %12s %12s %8s %10s %10s\n",
+           "", "weight", "bias", "loss(fp32)", "samples/s", "MB", "dw", "db");
+
+    float ref_w = 0.0f, ref_b = 0.0f;
+    for (int p = PRECISION_FP32; p <= PRECISION_BF16; p++) {
+        Dataset data;
+        if (p == PRECISION_FP32) {
+            data = base;
+        } else if (dataset_convert(&data, &base, (DataPrecision)p) != 0) {
+            printf("  %-5s allocation failed\n", dataset_precision_name((DataPrecision)p));
+            continue;
+        }
+
+        AICore trial = *core;
+        trial.weight = 0.0f;
+        trial.bias = 0.0f;
+
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        EpochKernel epoch_kernel = ai_block_select_kernel(&trial, &data);
+        for (int epoch = 0; epoch < trial.epochs; epoch++) {
+            EpochSums sums;
+            epoch_kernel(&trial, &data, &sums);
+            ai_block_step(&trial, &sums);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+        // Evaluate every model against the full-precision data
+        EpochSums eval;
+        ai_block_epoch(&trial, &base, &eval);
+        if (p == PRECISION_FP32) {
+            ref_w = trial.weight;
+            ref_b = trial.bias;
+        }
+
+        printf("  %-5s %10.5f %10.5f %12.5f %12.3e %8.2f %10.2e %10.2e\n",
+               dataset_precision_name((DataPrecision)p), trial.weight, trial.bias,
+               eval.count ? eval.loss / eval.count : 0.0f,
+               seconds > 0 ? (double)data.size * trial.epochs / seconds : 0.0,
+               dataset_bytes(&data) / 1e6, trial.weight - ref_w, trial.bias - ref_b);
+
+        if (p != PRECISION_FP32) {
+            dataset_free(&data);
+        }
+    }
+
+    dataset_free(&base);
+    return 0;
+}
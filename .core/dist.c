@@ -0,0 +1,546 @@
+/*
+
+    OneCoreAI - Data-Parallel Training
+
+    Trains one linear core with N worker processes, each owning a shard
+    of the dataset: a range of the generator's stream that the worker
+    generates itself, or a slice of a loaded file shared copy-on-write.
+    Every epoch each worker sums loss and gradients over its shard, the
+    partial EpochSums are all-reduced, and every worker takes the same
+    full-batch step, so the parameters stay identical across workers and
+    match single-process training up to float summation order.
+
+    The all-reduce sits behind a small transport interface: a shared
+    memory barrier on one host, or a star over Unix or loopback TCP
+    sockets standing in for workers on separate nodes. Every transport
+    adds the partial sums in rank order, so all of them produce the same
+    bits.
+
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "handle.h"
+#include "trace.h"
+
+#define DIST_MAX_WORKERS 64
+#define DIST_DEFAULT_SAMPLES 1000000
+
+// Partial sums as exchanged between workers
+typedef struct {
+    float loss;
+    float dw;
+    float db;
+    uint32_t reserved;
+    uint64_t count;
+} DistSums;
+
+// One worker's partial sums, alone on its cache line
+typedef struct {
+    DistSums sums;
+    char pad[64 - sizeof(DistSums)];
+} DistSlot;
+
+// Mapped shared before the fork: shm transport state and rank 0's results
+typedef struct {
+    pthread_barrier_t barrier;
+    DistSlot slots[2][DIST_MAX_WORKERS];    // Alternate epochs, so one barrier per epoch
+    AICore result;
+    double compute_seconds;                 // Rank 0: epoch kernels
+    double reduce_seconds;                  // Rank 0: waiting in the all-reduce
+} DistShared;
+
+typedef struct DistTransport DistTransport;
+
+// All-reduce transport. setup and teardown run in the parent around the
+// fork; attach runs in each worker before its first epoch.
+struct DistTransport {
+    const char *name;
+    int (*setup)(DistTransport *t);
+    int (*attach)(DistTransport *t, int rank);
+    int (*allreduce)(DistTransport *t, int rank, int epoch, EpochSums *sums);
+    void (*teardown)(DistTransport *t);
+
+    int workers;
+    DistShared *shared;
+    int pairs[DIST_MAX_WORKERS][2];         // unix: socketpair per rank > 0
+    int listen_fd;                          // tcp: rank 0 accepts here
+    struct sockaddr_in address;
+    int peers[DIST_MAX_WORKERS];            // Rank 0: socket to each rank; others: peers[0]
+};
+
+static double dist_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static DistSums dist_pack(const EpochSums *sums) {
+    return (DistSums){ .loss = sums->loss, .dw = sums->dw, .db = sums->db, .count = sums->count };
+}
+
+// total += part, in the order the caller goes through the ranks
+static void dist_add(EpochSums *total, const DistSums *part) {
+    total->loss += part->loss;
+    total->dw += part->dw;
+    total->db += part->db;
+    total->count += part->count;
+}
+
+// Shared memory transport
+
+static int shm_setup(DistTransport *t) {
+    pthread_barrierattr_t attr;
+    pthread_barrierattr_init(&attr);
+    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    int result = pthread_barrier_init(&t->shared->barrier, &attr, t->workers);
+    pthread_barrierattr_destroy(&attr);
+    return result == 0 ? 0 : -1;
+}
+
+static int shm_attach(DistTransport *t, int rank) {
+    (void)t;
+    (void)rank;
+    return 0;
+}
+
+static int shm_allreduce(DistTransport *t, int rank, int epoch, EpochSums *sums) {
+    DistSlot *slots = t->shared->slots[epoch & 1];
+    slots[rank].sums = dist_pack(sums);
+    pthread_barrier_wait(&t->shared->barrier);
+
+    EpochSums total = { 0 };
+    for (int r = 0; r < t->workers; r++) {
+        dist_add(&total, &slots[r].sums);
+    }
+    *sums = total;
+    return 0;
+}
+
+static void shm_teardown(DistTransport *t) {
+    pthread_barrier_destroy(&t->shared->barrier);
+}
+
+// Socket transports: rank 0 is the hub of a star
+
+static int dist_write(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int dist_read(int fd, void *buf, size_t len) {
+    char *p = buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int star_allreduce(DistTransport *t, int rank, int epoch, EpochSums *sums) {
+    (void)epoch;
+    DistSums part = dist_pack(sums);
+    if (rank != 0) {
+        if (dist_write(t->peers[0], &part, sizeof(part)) != 0 ||
+            dist_read(t->peers[0], &part, sizeof(part)) != 0) {
+            return -1;
+        }
+        *sums = (EpochSums){ 0 };
+        dist_add(sums, &part);
+        return 0;
+    }
+
+    EpochSums total = { 0 };
+    dist_add(&total, &part);
+    for (int r = 1; r < t->workers; r++) {
+        if (dist_read(t->peers[r], &part, sizeof(part)) != 0) {
+            return -1;
+        }
+        dist_add(&total, &part);
+    }
+    part = dist_pack(&total);
+    for (int r = 1; r < t->workers; r++) {
+        if (dist_write(t->peers[r], &part, sizeof(part)) != 0) {
+            return -1;
+        }
+    }
+    *sums = total;
+    return 0;
+}
+
+static int unix_setup(DistTransport *t) {
+    for (int r = 1; r < t->workers; r++) {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, t->pairs[r]) != 0) {
+            while (--r >= 1) {
+                close(t->pairs[r][0]);
+                close(t->pairs[r][1]);
+            }
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Keep this rank's ends of the socketpairs and close the rest
+static int unix_attach(DistTransport *t, int rank) {
+    for (int r = 1; r < t->workers; r++) {
+        if (rank == 0) {
+            t->peers[r] = t->pairs[r][0];
+            close(t->pairs[r][1]);
+        } else if (r == rank) {
+            t->peers[0] = t->pairs[r][1];
+            close(t->pairs[r][0]);
+        } else {
+            close(t->pairs[r][0]);
+            close(t->pairs[r][1]);
+        }
+    }
+    return 0;
+}
+
+static void unix_teardown(DistTransport *t) {
+    for (int r = 1; r < t->workers; r++) {
+        close(t->pairs[r][0]);
+        close(t->pairs[r][1]);
+    }
+}
+
+static int tcp_setup(DistTransport *t) {
+    t->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (t->listen_fd < 0) {
+        return -1;
+    }
+    socklen_t length = sizeof(t->address);
+    memset(&t->address, 0, sizeof(t->address));
+    t->address.sin_family = AF_INET;
+    t->address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    t->address.sin_port = 0;  // Any free port
+    if (bind(t->listen_fd, (struct sockaddr *)&t->address, sizeof(t->address)) != 0 ||
+        listen(t->listen_fd, t->workers) != 0 ||
+        getsockname(t->listen_fd, (struct sockaddr *)&t->address, &length) != 0) {
+        close(t->listen_fd);
+        return -1;
+    }
+    return 0;
+}
+
+// Rank 0 accepts every other rank, which introduces itself with its rank number
+static int tcp_attach(DistTransport *t, int rank) {
+    int one = 1;
+    if (rank == 0) {
+        for (int i = 1; i < t->workers; i++) {
+            int fd = accept(t->listen_fd, NULL, NULL);
+            int peer = -1;
+            if (fd < 0 || dist_read(fd, &peer, sizeof(peer)) != 0 || peer < 1 || peer >= t->workers) {
+                return -1;
+            }
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            t->peers[peer] = fd;
+        }
+        close(t->listen_fd);
+        return 0;
+    }
+
+    close(t->listen_fd);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&t->address, sizeof(t->address)) != 0) {
+        return -1;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    t->peers[0] = fd;
+    return dist_write(fd, &rank, sizeof(rank));
+}
+
+static void tcp_teardown(DistTransport *t) {
+    close(t->listen_fd);
+}
+
+static const DistTransport dist_transports[] = {
+    { .name = "shm",  .setup = shm_setup,  .attach = shm_attach,  .allreduce = shm_allreduce,  .teardown = shm_teardown },
+    { .name = "unix", .setup = unix_setup, .attach = unix_attach, .allreduce = star_allreduce, .teardown = unix_teardown },
+    { .name = "tcp",  .setup = tcp_setup,  .attach = tcp_attach,  .allreduce = star_allreduce, .teardown = tcp_teardown },
+};
+
+// Workers
+
+typedef struct {
+    DistTransport transport;
+    AICore core;                  // Starting parameters
+    const Dataset *data;          // Loaded dataset to slice, or NULL to generate shards
+    GeneratorConfig generator;    // Source of generated shards
+    DataPrecision precision;
+    size_t samples;
+    int workers;
+    TraceShare *trace;            // Where traced workers leave their events
+} DistRun;
+
+static void dist_pin(int rank) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    if (online < 1) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(rank % online, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+}
+
+// Body of worker `rank` (a forked child). Returns its exit status.
+static int dist_worker(DistRun *run, int rank) {
+    DistTransport *t = &run->transport;
+    dist_pin(rank);
+    trace_child(run->trace, rank);
+    trace_name_thread("dist rank %d", rank);
+    if (t->attach(t, rank) != 0) {
+        return 1;
+    }
+
+    size_t start = run->samples * rank / run->workers;
+    size_t count = run->samples * (rank + 1) / run->workers - start;
+    Dataset shard;
+    if (run->data) {
+        dataset_view(&shard, run->data, start, count);
+    } else {
+        // One generator thread per worker: the workers are the parallelism
+        GeneratorConfig config = run->generator;
+        config.threads = 1;
+        if (config.implicit) {
+            generator_implicit(&shard, &config, start, count);
+        } else {
+            if (dataset_alloc(&shard, count, run->precision) != 0) {
+                return 1;
+            }
+            generator_fill_from(&shard, &config, start);
+        }
+    }
+
+    AICore core = run->core;
+    core.loss_count = 0;
+    EpochKernel epoch_kernel = ai_block_select_kernel(&core, &shard);
+    int grouped = ai_block_uses_sheet_stats(&core) && core.epochs > 1;
+    SheetStats stats;
+    if (grouped) {
+        ai_block_sheet_stats(&shard, &stats);
+    }
+    double compute = 0.0, reduce = 0.0;
+
+    for (int epoch = 0; epoch < core.epochs; epoch++) {
+        EpochSums sums;
+        TRACE_BEGIN(TRACE_EPOCH, core.id, epoch + 1);
+        TRACE_BEGIN(TRACE_GRADIENTS, core.id, epoch + 1);
+        double t0 = dist_now();
+        if (grouped) ai_block_epoch_grouped(&core, &stats, &sums);
+        else epoch_kernel(&core, &shard, &sums);
+        double t1 = dist_now();
+        TRACE_END(TRACE_GRADIENTS, core.id, epoch + 1);
+        TRACE_BEGIN(TRACE_REDUCE, core.id, epoch + 1);
+        if (t->allreduce(t, rank, epoch, &sums) != 0) {
+            return 1;
+        }
+        TRACE_END(TRACE_REDUCE, core.id, epoch + 1);
+        compute += t1 - t0;
+        reduce += dist_now() - t1;
+
+        TRACE_BEGIN(TRACE_UPDATE, core.id, epoch + 1);
+        float total_loss = ai_block_step(&core, &sums);
+        TRACE_END(TRACE_UPDATE, core.id, epoch + 1);
+        if (epoch < 100) {
+            if (total_loss != total_loss || total_loss > 1e10f || total_loss < -1e10f) {
+                total_loss = 1e10f;
+            }
+            core.loss_history[epoch] = total_loss;
+            core.loss_count++;
+        }
+        TRACE_END(TRACE_EPOCH, core.id, epoch + 1);
+    }
+
+    if (rank == 0) {
+        run->transport.shared->result = core;
+        run->transport.shared->compute_seconds = compute;
+        run->transport.shared->reduce_seconds = reduce;
+    }
+    return 0;
+}
+
+static const DistTransport *dist_find_transport(const char *name) {
+    for (size_t i = 0; i < sizeof(dist_transports) / sizeof(dist_transports[0]); i++) {
+        if (strcmp(dist_transports[i].name, name) == 0) {
+            return &dist_transports[i];
+        }
+    }
+    return NULL;
+}
+
+// Fork the workers and wait for all of them; if one fails the rest are killed
+static int dist_run_workers(DistRun *run) {
+    pid_t pids[DIST_MAX_WORKERS];
+    int started = 0, failed = 0;
+
+    fflush(stdout);
+    fflush(stderr);
+    // Epoch, gradients, all-reduce and update markers, plus generation
+    run->trace = trace_share_create(run->workers, (size_t)run->core.epochs * 8 + 64);
+    for (int rank = 0; rank < run->workers; rank++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            int status = dist_worker(run, rank);
+            trace_child_exit();
+            _exit(status);
+        }
+        if (pid < 0) {
+            failed = 1;
+            break;
+        }
+        pids[started++] = pid;
+    }
+
+    int remaining = started;
+    while (remaining > 0) {
+        if (failed) {
+            for (int i = 0; i < started; i++) {
+                if (pids[i] > 0) kill(pids[i], SIGKILL);
+            }
+        }
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < started; i++) {
+            if (pids[i] == pid) {
+                pids[i] = 0;
+                remaining--;
+                if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = 1;
+            }
+        }
+    }
+    trace_share_collect(run->trace);
+    return failed ? -1 : 0;
+}
+
+// Train a linear core on `source` (a sample count for generated data, or a
+// dataset file) with `workers` processes all-reducing over `transport`
+int dist_train(OneCoreCtx *ctx, int core_id, int workers, const char *source, const char *transport) {
+    AICore *core = core_get(ctx, core_id);
+    if (!core) {
+        printf("Invalid core ID: %d\n", core_id);
+        return -1;
+    }
+    if (core->type != CORE_LINEAR) {
+        printf("Core %d is an MLP core; data-parallel training runs linear cores.\n", core_id);
+        return -1;
+    }
+    if (workers < 1 || workers > DIST_MAX_WORKERS) {
+        printf("Workers must be 1-%d.\n", DIST_MAX_WORKERS);
+        return -1;
+    }
+    const DistTransport *kind = dist_find_transport(transport ? transport : "shm");
+    if (!kind) {
+        printf("Unknown transport: %s (shm, unix or tcp)\n", transport);
+        return -1;
+    }
+
+    // A sample count is generated shard by shard in the workers; a file is
+    // loaded here and sliced
+    Dataset loaded;
+    char *end = NULL;
+    size_t samples = source ? strtoull(source, &end, 10) : DIST_DEFAULT_SAMPLES;
+    int from_file = source && (end == source || *end != '\0');
+    if (from_file) {
+        if (dataset_load_file(&loaded, source, onecore_precision(ctx)) != 0) {
+            printf("Failed to load dataset %s\n", source);
+            return -1;
+        }
+        samples = loaded.size;
+    }
+    if (samples < (size_t)workers) {
+        printf("Need at least one sample per worker.\n");
+        if (from_file) dataset_free(&loaded);
+        return -1;
+    }
+
+    DistShared *shared = mmap(NULL, sizeof(DistShared), PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        printf("Failed to map shared state.\n");
+        if (from_file) dataset_free(&loaded);
+        return -1;
+    }
+
+    DistRun run = {
+        .transport = *kind, .data = from_file ? &loaded : NULL,
+        .generator = *onecore_generator(ctx), .precision = onecore_precision(ctx),
+        .samples = samples, .workers = workers
+    };
+    run.transport.workers = workers;
+    run.transport.shared = shared;
+    int result = run.transport.setup(&run.transport);
+    if (result != 0) {
+        printf("Failed to set up the %s transport.\n", kind->name);
+    }
+
+    if (result == 0) {
+        printf("Data-parallel training of Core %d (%s): %d worker(s), %s all-reduce, %zu samples, %d epochs\n",
+               core_id, core->name, workers, kind->name, samples, core->epochs);
+        core_lock(ctx, core_id);
+        run.core = *core;
+        double start = dist_now();
+        result = dist_run_workers(&run);
+        double seconds = dist_now() - start;
+
+        if (result == 0) {
+            const AICore *trained = &shared->result;
+            core->weight = trained->weight;
+            core->bias = trained->bias;
+            memcpy(core->loss_history, trained->loss_history, sizeof(core->loss_history));
+            core->loss_count = trained->loss_count;
+            core->trained = 1;
+            stream_restart(core);
+            snapshot_publish_core(ctx, core);
+        }
+        core_unlock(ctx, core_id);
+        run.transport.teardown(&run.transport);
+
+        if (result == 0) {
+            double epoch_time = shared->compute_seconds + shared->reduce_seconds;
+            printf("  %.3f s (%.1f M samples/s over all epochs); all-reduce %.1f%% of rank 0's epoch time (%.1f us/epoch)\n",
+                   seconds, seconds > 0 ? (double)samples * core->epochs / seconds / 1e6 : 0.0,
+                   epoch_time > 0 ? 100.0 * shared->reduce_seconds / epoch_time : 0.0,
+                   core->epochs > 0 ? 1e6 * shared->reduce_seconds / core->epochs : 0.0);
+            printf("  Final: loss %.6f, w = %.6f, b = %.6f\n",
+                   core->loss_count > 0 ? core->loss_history[core->loss_count - 1] : 0.0f,
+                   core->weight, core->bias);
+        } else {
+            printf("Data-parallel training failed (a worker exited early).\n");
+        }
+    }
+
+    munmap(shared, sizeof(DistShared));
+    if (from_file) dataset_free(&loaded);
+    return result;
+}
@@ -0,0 +1,364 @@
+/*
+
+    OneCoreAI - Synthetic Data Generator
+
+    Generates y = slope * x + intercept + noise samples with random data
+    sheets. Every random value is a counter-based hash of (seed, sample
+    index, draw), splitmix64-style, instead of the global rand() state:
+    any range of samples can be produced on its own, on any thread, and
+    the output for a seed is bit-identical whatever the thread count.
+
+    The stream is described as three implicit dataset columns (x affine in
+    the index, y and the data sheet counter-random). Filling a dataset
+    stores them; with `gen implicit on` training reads them straight from
+    the descriptors instead, so the data costs no memory at any size.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "handle.h"
+#include "trace.h"
+
+// x follows the same 0-10 grid as the original generator: (i % 1000) / 100
+#define GEN_X_PERIOD 1000
+#define GEN_X_DIVISOR 100.0f
+
+// Samples per thread below which generation stays on the calling thread
+#define GEN_MIN_PER_THREAD (64 * 1024)
+
+// More threads than this per CPU only add scheduling overhead
+#define GEN_MAX_THREADS_PER_CPU 4
+
+// Training set size of a new context
+#define GEN_DEFAULT_SAMPLES 1000
+
+// Hash draws of a sample: its key is index * GEN_DRAWS + draw + 1
+#define GEN_DRAW_Y 0
+#define GEN_DRAW_SHEET 1
+#define GEN_DRAWS 2
+
+// Tag of a random x column's own stream (see gen_x_seed)
+#define GEN_STREAM_X 0x2545F4914F6CDD1Dull
+
+// Default settings of a new context: y = 2x + 1 + U(-1, 1), every sheet bit at 1/2
+void generator_defaults(GeneratorConfig *config) {
+    *config = (GeneratorConfig){
+        .seed = 42,
+        .slope = 2.0f,
+        .intercept = 1.0f,
+        .noise = 1.0f,
+        .sheet_prob = { 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f },
+        .threads = 0,
+        .samples = GEN_DEFAULT_SAMPLES,
+        .implicit = 0
+    };
+}
+
+static inline uint64_t gen_mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Random 64 bits for draw `draw` of sample `index`
+static inline uint64_t gen_random(uint64_t seed, uint64_t index, uint64_t draw) {
+    return gen_mix(seed + (index * GEN_DRAWS + draw + 1) * 0x9E3779B97F4A7C15ull);
+}
+
+// A random x column draws from a stream of its own: the seed goes through
+// one more splitmix round, so x never reuses the y or sheet draws of any
+// sample (keys past GEN_DRAWS would be the next sample's)
+static inline uint64_t gen_x_seed(uint64_t seed) {
+    return gen_mix(seed ^ GEN_STREAM_X);
+}
+
+// Data sheet byte of a non-random sheet column value, clamped to 0-255
+unsigned char generator_sheet_byte(float value) {
+    if (!(value > 0.0f)) return 0;
+    if (value >= 255.0f) return 255;
+    return (unsigned char)value;
+}
+
+// Per-bit thresholds: bit b is set when byte b of a draw is below thresholds[b]
+static void gen_thresholds(const GeneratorConfig *config, unsigned int *thresholds) {
+    for (int b = 0; b < 8; b++) {
+        float p = config->sheet_prob[b];
+        p = p < 0.0f ? 0.0f : (p > 1.0f ? 1.0f : p);
+        thresholds[b] = (unsigned int)(p * 256.0f + 0.5f);
+    }
+}
+
+// Values [first, first + count) of an implicit x or y column. x holds the
+// samples' x values when computing y, and is NULL when computing x.
+void generator_column(const DatasetColumn *column, uint64_t first, size_t count,
+                      const float *x, float *out) {
+    switch (column->kind) {
+        case COLUMN_AFFINE: {
+            uint64_t period = column->period;
+            uint64_t k = period ? first % period : first;
+            for (size_t i = 0; i < count; i++) {
+                out[i] = column->value + (float)k / column->divisor;
+                if (++k == period) k = 0;
+            }
+            break;
+        }
+        case COLUMN_RANDOM: {
+            // 24 random bits -> uniform [-1, 1)
+            const uint64_t seed = x ? column->seed : gen_x_seed(column->seed), draw = GEN_DRAW_Y;
+            const float slope = column->slope, value = column->value, noise = column->noise;
+            if (x) {
+                for (size_t i = 0; i < count; i++) {
+                    float u = (float)(gen_random(seed, first + i, draw) >> 40) * (1.0f / 16777216.0f);
+                    out[i] = slope * x[i] + value + (2.0f * u - 1.0f) * noise;
+                }
+            } else {
+                for (size_t i = 0; i < count; i++) {
+                    float u = (float)(gen_random(seed, first + i, draw) >> 40) * (1.0f / 16777216.0f);
+                    out[i] = value + (2.0f * u - 1.0f) * noise;
+                }
+            }
+            break;
+        }
+        default:
+            for (size_t i = 0; i < count; i++) out[i] = column->value;
+            break;
+    }
+}
+
+// Data sheet bytes [first, first + count) of an implicit sheet column
+void generator_column_sheet(const DatasetColumn *column, uint64_t first, size_t count, unsigned char *out) {
+    if (column->kind != COLUMN_RANDOM) {
+        float values[DATASET_CHUNK];
+        for (size_t done = 0; done < count; done += DATASET_CHUNK) {
+            size_t n = count - done < DATASET_CHUNK ? count - done : DATASET_CHUNK;
+            generator_column(column, first + done, n, NULL, values);
+            for (size_t i = 0; i < n; i++) out[done + i] = generator_sheet_byte(values[i]);
+        }
+        return;
+    }
+    const unsigned int *thresholds = column->threshold;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t bits = gen_random(column->seed, first + i, GEN_DRAW_SHEET);
+        unsigned char hex = 0;
+        for (int b = 0; b < 8; b++) {
+            if (((bits >> (8 * b)) & 0xFF) < thresholds[b]) hex |= (unsigned char)(1u << b);
+        }
+        out[i] = hex;
+    }
+}
+
+// Samples [first, first + size) of the stream as an implicit dataset: no
+// storage, and every chunk read gives what generator_fill_from would store
+void generator_implicit(Dataset *data, const GeneratorConfig *config, uint64_t first, size_t size) {
+    memset(data, 0, sizeof(*data));
+    data->size = size;
+    data->precision = PRECISION_FP32;
+    data->first = first;
+    data->x_column = (DatasetColumn){
+        .kind = COLUMN_AFFINE, .value = 0.0f, .divisor = GEN_X_DIVISOR, .period = GEN_X_PERIOD
+    };
+    data->y_column = (DatasetColumn){
+        .kind = COLUMN_RANDOM, .slope = config->slope, .value = config->intercept,
+        .noise = config->noise, .seed = config->seed
+    };
+    data->sheet_column = (DatasetColumn){ .kind = COLUMN_RANDOM, .seed = config->seed };
+    gen_thresholds(config, data->sheet_column.threshold);
+}
+
+typedef struct {
+    const Dataset *stream;    // The generator's samples, implicit
+    Dataset *data;            // Fill this, or (bench) just checksum
+    uint64_t first;           // Sample index stored at data position 0
+    uint64_t begin;
+    uint64_t end;
+    uint64_t checksum;
+    pthread_t thread;
+    int started;              // thread is running (else the task runs inline)
+} GenerateTask;
+
+static uint64_t float_checksum(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static void *gen_task(void *arg) {
+    GenerateTask *task = arg;
+    TRACE_BEGIN(TRACE_GENERATE, -1, (int64_t)(task->end - task->begin));
+
+    for (uint64_t start = task->begin; start < task->end; start += DATASET_CHUNK) {
+        DatasetChunk chunk;
+        size_t count = dataset_chunk(task->stream, start - task->first, DATASET_CHUNK, &chunk);
+        if (task->data) {
+            dataset_set(task->data, start - task->first, chunk.x, chunk.y, chunk.data_sheet, count);
+        } else {
+            // Order-independent sum, so the total does not depend on the split
+            for (size_t i = 0; i < count; i++) {
+                task->checksum += (float_checksum(chunk.x[i]) << 32 | float_checksum(chunk.y[i])) ^
+                                  ((uint64_t)chunk.data_sheet[i] * 0x9E3779B97F4A7C15ull) ^ (start + i);
+            }
+        }
+    }
+    TRACE_END(TRACE_GENERATE, -1, (int64_t)(task->end - task->begin));
+    return NULL;
+}
+
+static void *gen_thread(void *arg) {
+    trace_name_thread("generator");
+    return gen_task(arg);
+}
+
+// Threads for `samples`: the requested count (bench), the configured one or
+// one per CPU, never more than GEN_MAX_THREADS_PER_CPU per CPU or one per chunk
+static int gen_thread_count(const GeneratorConfig *config, uint64_t samples, int requested) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    if (online < 1) online = 1;
+    int threads = requested > 0 ? requested : (config->threads > 0 ? config->threads : (int)online);
+    uint64_t useful = samples / GEN_MIN_PER_THREAD;
+    if (requested <= 0 && (uint64_t)threads > useful) threads = (int)useful;
+    if (threads > online * GEN_MAX_THREADS_PER_CPU) threads = (int)(online * GEN_MAX_THREADS_PER_CPU);
+    uint64_t chunks = (samples + DATASET_CHUNK - 1) / DATASET_CHUNK;
+    if ((uint64_t)threads > chunks) threads = (int)chunks;
+    return threads < 1 ? 1 : threads;
+}
+
+// Split [first, first + samples) into chunk-aligned blocks and run them on `threads` threads
+static uint64_t gen_run(const GeneratorConfig *config, Dataset *data, uint64_t first, uint64_t samples,
+                        int threads) {
+    Dataset stream;
+    generator_implicit(&stream, config, first, samples);
+
+    GenerateTask *tasks = calloc(threads, sizeof(GenerateTask));
+    if (!tasks) {
+        threads = 1;
+    }
+    GenerateTask single;
+    if (!tasks) tasks = &single;
+
+    uint64_t chunks = (samples + DATASET_CHUNK - 1) / DATASET_CHUNK;
+    for (int t = 0; t < threads; t++) {
+        uint64_t begin = chunks * t / threads * DATASET_CHUNK;
+        uint64_t end = chunks * (t + 1) / threads * DATASET_CHUNK;
+        tasks[t] = (GenerateTask){
+            .stream = &stream, .data = data, .first = first,
+            .begin = first + (begin < samples ? begin : samples),
+            .end = first + (end < samples ? end : samples)
+        };
+    }
+
+    // Task 0 runs here; the rest on their own threads (inline if creation fails)
+    for (int t = 1; t < threads; t++) {
+        tasks[t].started = pthread_create(&tasks[t].thread, NULL, gen_thread, &tasks[t]) == 0;
+    }
+    gen_task(&tasks[0]);
+    uint64_t checksum = tasks[0].checksum;
+    for (int t = 1; t < threads; t++) {
+        if (tasks[t].started) pthread_join(tasks[t].thread, NULL);
+        else gen_task(&tasks[t]);
+        checksum += tasks[t].checksum;
+    }
+
+    if (tasks != &single) free(tasks);
+    return checksum;
+}
+
+// Fill every sample of an allocated dataset
+void generator_fill(Dataset *data, const GeneratorConfig *config) {
+    generator_fill_from(data, config, 0);
+}
+
+// Fill a dataset with samples [first, first + size) of the stream (a shard
+// of a larger dataset; the values match what a full fill puts there)
+void generator_fill_from(Dataset *data, const GeneratorConfig *config, uint64_t first) {
+    gen_run(config, data, first, data->size, gen_thread_count(config, data->size, 0));
+}
+
+static double gen_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Generate `samples` without storing them and report speed and checksum
+int generator_bench(const GeneratorConfig *config, uint64_t samples, int threads) {
+    if (samples == 0) {
+        printf("Sample count must be positive.\n");
+        return -1;
+    }
+    threads = gen_thread_count(config, samples, threads);
+    double start = gen_now();
+    uint64_t checksum = gen_run(config, NULL, 0, samples, threads);
+    double seconds = gen_now() - start;
+
+    printf("Generated %llu samples on %d thread(s) in %.3f s (%.1f M samples/s)\n",
+           (unsigned long long)samples, threads, seconds, seconds > 0 ? samples / seconds / 1e6 : 0.0);
+    printf("  Checksum: %016llx (seed %llu)\n", (unsigned long long)checksum,
+           (unsigned long long)config->seed);
+    return 0;
+}
+
+void generator_report(const GeneratorConfig *c) {
+    printf("Generator: y = %.4f * x + %.4f + U(-%.4f, %.4f), seed %llu, threads ",
+           c->slope, c->intercept, c->noise, c->noise, (unsigned long long)c->seed);
+    if (c->threads > 0) printf("%d\n", c->threads);
+    else printf("auto\n");
+    printf("  Data sheet bit probabilities:");
+    for (int b = 0; b < 8; b++) printf(" %.3f", c->sheet_prob[b]);
+    printf("\n");
+    printf("  Training set: %llu samples, %s\n", (unsigned long long)c->samples,
+           c->implicit ? "implicit (computed as read, nothing stored)" : "stored");
+}
+
+// 'gen' command: gen [seed|slope|intercept|noise|threads|samples <v>] [implicit on|off]
+//                    [sheet <p>|<p0..p7>] [bench <n> [threads]]
+int generator_command(OneCoreCtx *ctx, int argc, char **argv) {
+    GeneratorConfig *c = onecore_generator(ctx);
+    if (argc < 2) {
+        generator_report(c);
+        return 0;
+    }
+    const char *what = argv[1];
+    if (strcmp(what, "bench") == 0 && argc >= 3) {
+        return generator_bench(c, strtoull(argv[2], NULL, 10), argc >= 4 ? atoi(argv[3]) : 0);
+    }
+    if (argc < 3) {
+        printf("Usage: gen <seed|slope|intercept|noise|threads|samples|implicit|sheet|bench> <value>\n");
+        return -1;
+    }
+    if (strcmp(what, "seed") == 0) {
+        c->seed = strtoull(argv[2], NULL, 0);
+    } else if (strcmp(what, "slope") == 0) {
+        c->slope = atof(argv[2]);
+    } else if (strcmp(what, "intercept") == 0) {
+        c->intercept = atof(argv[2]);
+    } else if (strcmp(what, "noise") == 0) {
+        c->noise = atof(argv[2]);
+    } else if (strcmp(what, "threads") == 0) {
+        c->threads = atoi(argv[2]) > 0 ? atoi(argv[2]) : 0;
+    } else if (strcmp(what, "samples") == 0) {
+        uint64_t samples = strtoull(argv[2], NULL, 10);
+        if (samples == 0) {
+            printf("Training set needs at least one sample.\n");
+            return -1;
+        }
+        c->samples = samples;
+    } else if (strcmp(what, "implicit") == 0) {
+        c->implicit = strcmp(argv[2], "on") == 0;
+    } else if (strcmp(what, "sheet") == 0) {
+        // One probability for every bit, or one per bit (bit 0 first)
+        for (int b = 0; b < 8; b++) {
+            c->sheet_prob[b] = atof(argv[argc >= 10 ? 2 + b : 2]);
+        }
+    } else {
+        printf("Unknown generator setting: %s\n", what);
+        return -1;
+    }
+    generator_report(c);
+    return 0;
+}
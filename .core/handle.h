@@ -8,6 +8,18 @@
 #ifndef HANDLE_H
 #define HANDLE_H
 
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+// The library is built with hidden visibility; everything declared here is
+// its exported API
+#pragma GCC visibility push(default)
+
+// Maximum number of cores in the system
+#define MAX_CORES 30
+
 // Loss function types
 typedef enum {
     LOSS_MSE = 0,    // Mean Squared Error
@@ -15,6 +27,44 @@ typedef enum {
     LOSS_HUBER = 2   // Huber Loss (robust to outliers)
 } LossType;
 
+// Model a core trains and predicts with
+typedef enum {
+    CORE_LINEAR = 0,     // prediction = w * x + b
+    CORE_MLP = 1         // Multi-layer perceptron (see mlp.c)
+} CoreType;
+
+// Hidden layer activation of an MLP core
+typedef enum {
+    MLP_RELU = 0,
+    MLP_TANH = 1
+} MlpActivation;
+
+typedef struct MlpModel MlpModel;
+
+// Maximum absolute value of an averaged gradient component
+#define GRADIENT_CLIP 5.0f
+
+// One engine instance: its cores, datasets and settings (see context.h).
+// Contexts are independent; every core and training API takes one.
+typedef struct OneCoreCtx OneCoreCtx;
+
+// Streaming learner of a linear core (see stream.c): exponentially weighted
+// sums over the samples seen so far, O(1) in memory and per sample
+typedef struct {
+    int enabled;
+    float forget;               // Weight of a sample decays by this per newer sample (0, 1]
+    float alert;                // Window loss that flags drift (0: off)
+    double n;                   // Decayed sample count
+    double sx, sxx;             // Loss-weighted sums of x, x^2, 1, y and xy
+    double sw, sy, sxy;
+    double prior;               // Pull towards prior_w/prior_b, fades like an old sample
+    float prior_w, prior_b;
+    double loss;                // Decayed sum of each sample's loss before learning from it
+    uint64_t samples;
+    uint64_t alerts;            // Times the window loss rose above alert
+    int drifting;
+} StreamState;
+
 // AI Core structure - represents a single AI processing unit
 typedef struct {
     int id;
@@ -29,13 +79,233 @@ typedef struct {
     LossType loss_type;  // Type of loss function to use
     float regularization_lambda;  // L2 regularization coefficient
     float huber_delta;   // Delta parameter for Huber loss
+    CoreType type;
+    MlpModel *mlp;       // Owned by the core when type is CORE_MLP
+    StreamState stream;  // 'learn' updates through this when enabled
 } AICore;
 
+// Published parameters of a core, as seen by readers (see snapshot.c)
+typedef struct {
+    float weight;
+    float bias;
+    float learning_rate;
+    int epochs;
+    int trained;
+    int type;            // CoreType; weight and bias only mean something for CORE_LINEAR
+} CoreParams;
+
+// Data structure for training samples
+typedef struct {
+    unsigned char data_sheet;  // Hexadecimal data sheet for logic control
+    float x;
+    float y;
+} TrainingData;
+
+// Storage precision of dataset columns
+typedef enum {
+    PRECISION_FP32 = 0,
+    PRECISION_FP16 = 1,  // IEEE half
+    PRECISION_BF16 = 2   // bfloat16 (fp32 exponent, 7-bit mantissa)
+} DataPrecision;
+
+// Bump allocator for per-run memory (see arena.c)
+typedef struct {
+    char *base;
+    size_t capacity;
+    size_t used;
+    size_t peak;
+    size_t reserved;            // Bytes the current run asked for
+    int huge;                   // Backed by MAP_HUGETLB pages
+} Arena;
+
+// Synthetic data: y = slope * x + intercept + U(-noise, noise) (see generator.c)
+typedef struct {
+    uint64_t seed;
+    float slope;
+    float intercept;
+    float noise;
+    float sheet_prob[8];        // Probability of each data sheet bit
+    int threads;                // 0: one per CPU for large datasets
+    uint64_t samples;           // Training set size of train, run and resume
+    int implicit;               // Compute samples when read instead of storing them
+} GeneratorConfig;
+
+// Where parallel training keeps its read-only dataset (see numa.c)
+typedef enum {
+    NUMA_LOCAL = 0,      // Stay on the allocating node, train there
+    NUMA_REPLICATE = 1,  // Copy to every node, train each core next to its copy
+    NUMA_INTERLEAVE = 2  // Spread pages across nodes
+} NumaPolicy;
+
+// Bytes owned by one core (see memory.c)
+typedef struct {
+    size_t parameters;
+    size_t history;
+    size_t history_used;
+    size_t optimizer;
+    size_t snapshot;            // Published entry read by the server and shared memory
+    size_t dataset;             // Dataset it is training on now
+    size_t dataset_last;        // Dataset of its most recent run
+} CoreMemory;
+
+// Where a dataset column's values come from. Implicit columns are computed
+// from the sample's stream index i when a chunk is read (see generator.c):
+//   CONSTANT  value
+//   AFFINE    value + (i % period) / divisor        (period 0: no wrap)
+//   RANDOM    slope * x + value + noise * U(-1, 1), from a counter hash of (seed, i);
+//             for the data sheet, bit b is set when byte b of the hash is below threshold[b]
+typedef enum {
+    COLUMN_STORED = 0,
+    COLUMN_CONSTANT,
+    COLUMN_AFFINE,
+    COLUMN_RANDOM
+} ColumnKind;
+
+typedef struct {
+    ColumnKind kind;
+    float value;
+    float divisor;
+    uint64_t period;
+    float slope;
+    float noise;
+    uint64_t seed;
+    unsigned int threshold[8];
+} DatasetColumn;
+
+// Column-oriented training data (see dataset.c)
+typedef struct {
+    size_t size;
+    DataPrecision precision;
+    void *x;                    // float[] for fp32, uint16_t[] for fp16/bf16
+    void *y;
+    unsigned char *data_sheet;
+    Arena *arena;               // Columns belong to this arena, or NULL if malloc'd
+    DatasetColumn x_column;     // Stored columns use the arrays above
+    DatasetColumn y_column;
+    DatasetColumn sheet_column;
+    uint64_t first;             // Stream index of sample 0, for implicit columns
+} Dataset;
+
+// Samples decoded to fp32 for the training loop, at most DATASET_CHUNK at a time
+#define DATASET_CHUNK 256
+typedef struct {
+    const float *x;
+    const float *y;
+    const unsigned char *data_sheet;
+    float x_buf[DATASET_CHUNK];
+    float y_buf[DATASET_CHUNK];
+    unsigned char sheet_buf[DATASET_CHUNK];
+} DatasetChunk;
+
+// Loss and gradient sums over (part of) a dataset for one epoch
+typedef struct {
+    float loss;
+    float dw;
+    float db;
+    size_t count;
+} EpochSums;
+
+// Sufficient statistics of the samples with each data sheet value: an MSE
+// epoch over them costs O(256) whatever the dataset size (see kernel.c)
+typedef struct {
+    double n[256];
+    double x[256];
+    double y[256];
+    double xx[256];
+    double xy[256];
+    double yy[256];
+    unsigned char used[256];     // Sheet values that occur, in ascending order
+    int used_count;
+    size_t count;                // Samples summarized
+} SheetStats;
+
+// Specialized epoch loop for one loss/regularization/data sheet combination (see kernel.c)
+typedef void (*EpochKernel)(const AICore *core, const Dataset *data, EpochSums *sums);
+
+// Fixed-point version of a core for quantized inference (see quant.c)
+typedef struct {
+    int bits;            // Input precision: 8 or 16
+    int16_t weight_q;    // weight ~= weight_q * weight_scale
+    float weight_scale;
+    float input_scale;   // x ~= x_q * input_scale
+    float output_scale;  // weight_scale * input_scale
+    float bias;
+} QuantModel;
+
+// Cooperative control of a training run, checked once per epoch (see jobs.c)
+typedef struct {
+    _Atomic int cancel;          // Set to stop at the next epoch boundary
+    _Atomic long epochs_done;    // Epochs completed over all cores of the run
+    int quiet;                   // No per-core output (background jobs)
+    int headless;                // No visualization (parallel runs)
+} TrainControl;
+
+// Background training jobs
+typedef enum {
+    JOB_TRAIN = 0,       // train <core_id> ...
+    JOB_RUN = 1,         // run: every core
+    JOB_RESUME = 2       // resume <core_id> <file>
+} JobKind;
+
+typedef enum {
+    JOB_QUEUED = 0,
+    JOB_RUNNING = 1,
+    JOB_DONE = 2,
+    JOB_FAILED = 3,
+    JOB_CANCELLED = 4
+} JobState;
+
+// Asynchronous file operation (see aio.c)
+enum { AIO_READ, AIO_WRITE, AIO_FSYNC };
+
+typedef struct AioOp {
+    int opcode;          // AIO_READ, AIO_WRITE or AIO_FSYNC
+    int fd;
+    void *buf;
+    size_t len;
+    off_t offset;
+    int link;            // Run the next op in the batch only if this one succeeds
+    ssize_t result;      // Bytes transferred or -errno, once done
+    _Atomic int done;
+    struct iovec iov;    // Backend state
+    struct AioOp *chain;
+    struct AioOp *next;
+} AioOp;
+
 // Function prototypes
 
 // Learning logic function
 int learn_logic();
 
+// Engine contexts
+OneCoreCtx *onecore_create();
+void onecore_destroy(OneCoreCtx *ctx);
+void onecore_set_interactive(OneCoreCtx *ctx, int interactive);
+DataPrecision onecore_precision(const OneCoreCtx *ctx);
+void onecore_set_precision(OneCoreCtx *ctx, DataPrecision precision);
+GeneratorConfig *onecore_generator(OneCoreCtx *ctx);
+int onecore_core_count(const OneCoreCtx *ctx);
+
+// AI Block Functions - Forward pass and single-sample learning
+float ai_block_forward(float w, float b, float x);
+void ai_block_learn(AICore *core, float x, float y);
+float ai_block_predict(AICore *core, float x);
+void ai_block_extract_variables(AICore *core, float *w, float *b, float *lr, int *epochs);
+void ai_block_load_variables(AICore *core, float w, float b, float lr, int epochs);
+
+// Training blocks (the calling thread's TrainControl, if any, can stop them between epochs)
+void ai_block_set_control(TrainControl *control);
+TrainControl *ai_block_control();
+void ai_block_epoch(const AICore *core, const Dataset *data, EpochSums *sums);
+EpochKernel ai_block_select_kernel(const AICore *core, const Dataset *data);
+int ai_block_uses_sheet_stats(const AICore *core);
+void ai_block_sheet_stats(const Dataset *data, SheetStats *stats);
+void ai_block_epoch_grouped(const AICore *core, const SheetStats *stats, EpochSums *sums);
+float ai_block_step(AICore *core, const EpochSums *sums);
+int ai_block_train_dataset(OneCoreCtx *ctx, AICore *core, const Dataset *data, int start_epoch);
+int ai_block_train_from(OneCoreCtx *ctx, AICore *core, TrainingData *data, size_t data_size, int start_epoch);
+int ai_block_train(OneCoreCtx *ctx, AICore *core, TrainingData *data, size_t data_size);
+
 // AI Block Functions - Loss and Gradient Calculations
 float ai_block_loss(float prediction, float target);
 float ai_block_loss_mae(float prediction, float target);
@@ -47,25 +317,183 @@ void ai_block_gradients(float prediction, float target, float x, float *dw, floa
 void ai_block_gradients_advanced(float prediction, float target, float x, 
                                 float weight, float bias, float *dw, float *db,
                                 LossType loss_type, float delta, float lambda);
+float ai_block_loss_factor(float error, LossType loss_type, float delta, float *grad);
+
+// Persistence blocks (src.c)
+int ai_block_write_variables(FILE *file, const AICore *core, int epoch);
+int ai_block_save_to_file(OneCoreCtx *ctx, int core_id, const char *filename);
+int ai_block_load_from_file(OneCoreCtx *ctx, int core_id, const char *filename);
+int ai_block_load_checkpoint(OneCoreCtx *ctx, int core_id, const char *filename, int *epoch);
+
+// Run arenas
+int arena_init(Arena *arena, size_t capacity);
+void arena_destroy(Arena *arena);
+void *arena_alloc(Arena *arena, size_t size);
+void arena_reset(Arena *arena);
+size_t arena_size(size_t size);
+Arena *arena_run_begin(size_t bytes);
+void arena_run_end(Arena *arena);
+void arena_report();
+
+// Synthetic data generator
+void generator_defaults(GeneratorConfig *config);
+void generator_fill(Dataset *data, const GeneratorConfig *config);
+void generator_fill_from(Dataset *data, const GeneratorConfig *config, uint64_t first);
+void generator_implicit(Dataset *data, const GeneratorConfig *config, uint64_t first, size_t size);
+void generator_column(const DatasetColumn *column, uint64_t first, size_t count, const float *x, float *out);
+void generator_column_sheet(const DatasetColumn *column, uint64_t first, size_t count, unsigned char *out);
+unsigned char generator_sheet_byte(float value);
+int generator_bench(const GeneratorConfig *config, uint64_t samples, int threads);
+void generator_report(const GeneratorConfig *config);
+int generator_command(OneCoreCtx *ctx, int argc, char **argv);
+
+// NUMA-aware parallel training
+int numa_train_cores(OneCoreCtx *ctx, const int *core_ids, int count, const Dataset *data);
+int numa_set_policy(OneCoreCtx *ctx, const char *name);
+void numa_set_workers(OneCoreCtx *ctx, int workers);
+void numa_report(OneCoreCtx *ctx);
+
+// Data-parallel training across processes (dist.c)
+int dist_train(OneCoreCtx *ctx, int core_id, int workers, const char *source, const char *transport);
+
+// MLP cores (mlp.c)
+MlpModel *mlp_create(const int *hidden, int hidden_count, MlpActivation activation, int batch, uint64_t seed);
+void mlp_free(MlpModel *model);
+size_t mlp_bytes(const MlpModel *model);
+void mlp_describe(const MlpModel *model, char *out, size_t size);
+float mlp_predict(MlpModel *model, float x);
+float mlp_epoch(AICore *core, const Dataset *data);
+float mlp_evaluate(AICore *core, const Dataset *data);
+void mlp_learn(AICore *core, float x, float y);
+void mlp_bench(int size);
+int mlp_command(OneCoreCtx *ctx, int argc, char **argv);
+
+// Streaming learner (stream.c)
+int stream_enable(AICore *core, float forget);
+void stream_restart(AICore *core);
+void stream_disable(AICore *core);
+void stream_learn(AICore *core, float x, float y);
+void stream_learn_batch(AICore *core, const float *x, const float *y, size_t count);
+float stream_window_loss(const AICore *core);
+void stream_describe(const AICore *core);
+int stream_command(OneCoreCtx *ctx, int argc, char **argv);
+
+// Asynchronous I/O (aio.c)
+const char *aio_backend_name();
+void aio_submit(AioOp *ops, int count);
+ssize_t aio_wait(AioOp *op);
+int aio_wait_all(AioOp *ops, int count);
+void aio_report();
+
+// Memory accounting
+void memory_dataset_alloc(size_t bytes);
+void memory_dataset_free(size_t bytes);
+void memory_core_dataset(OneCoreCtx *ctx, int core_id, size_t bytes);
+void memory_core_deleted(OneCoreCtx *ctx, int core_id, int count);
+void memory_cores_cleared(OneCoreCtx *ctx);
+int memory_core(OneCoreCtx *ctx, int core_id, CoreMemory *out);
+int memory_process(size_t *virtual_bytes, size_t *resident, size_t *shared);
+int memory_report_core(OneCoreCtx *ctx, int core_id);
+void memory_report(OneCoreCtx *ctx);
+
+// Dataset storage
+int dataset_alloc(Dataset *data, size_t size, DataPrecision precision);
+int dataset_alloc_in(Dataset *data, size_t size, DataPrecision precision, Arena *arena);
+size_t dataset_arena_size(size_t size, DataPrecision precision);
+void dataset_free(Dataset *data);
+size_t dataset_bytes(const Dataset *data);
+void dataset_set(Dataset *data, size_t start, const float *x, const float *y,
+                 const unsigned char *data_sheet, size_t count);
+size_t dataset_chunk(const Dataset *data, size_t start, size_t count, DatasetChunk *chunk);
+int dataset_from_training_data(Dataset *data, const TrainingData *samples, size_t size,
+                               DataPrecision precision);
+int dataset_convert(Dataset *out, const Dataset *in, DataPrecision precision);
+int dataset_clone(Dataset *out, const Dataset *in, Arena *arena);
+void dataset_view(Dataset *out, const Dataset *in, size_t start, size_t count);
+int dataset_is_implicit(const Dataset *data);
+int dataset_load_file(Dataset *data, const char *filename, DataPrecision precision);
+const char *dataset_precision_name(DataPrecision precision);
+int dataset_parse_precision(const char *name, DataPrecision *precision);
+int dataset_compare_precision(OneCoreCtx *ctx, int core_id, const char *source);
+
+// Ensemble prediction block (src.c)
+float ai_block_ensemble_predict(OneCoreCtx *ctx, float x, int *core_ids, int num_cores);
+
+// Quantized inference
+int quant_model_init(QuantModel *model, float weight, float bias, int bits,
+                     const float *calibration, size_t count);
+void quant_quantize_inputs(const QuantModel *model, const float *x, void *x_q, size_t count);
+void quant_predict_batch(const QuantModel *model, const void *x_q, float *out, size_t count);
+int quant_report(OneCoreCtx *ctx, int bits, int *core_ids, int num_cores);
+
+// Background checkpointing
+int checkpoint_enable(OneCoreCtx *ctx, int epochs, double seconds, const char *dir);
+void checkpoint_disable();
+void checkpoint_release(OneCoreCtx *ctx);
+void checkpoint_status();
+void checkpoint_flush();
+void checkpoint_path(int core_id, char *path, size_t size);
+void checkpoint_after_epoch(OneCoreCtx *ctx, const AICore *core, int epoch);
 
 // Advanced Loss Analysis Functions
-void ai_block_loss_statistics(int core_id, float *min_loss, float *max_loss, float *avg_loss);
-int ai_block_loss_converged(int core_id, float tolerance);
+void ai_block_loss_statistics(OneCoreCtx *ctx, int core_id, float *min_loss, float *max_loss, float *avg_loss);
+int ai_block_loss_converged(OneCoreCtx *ctx, int core_id, float tolerance);
 float ai_block_loss_gradient_norm(float prediction, float target, float x, 
                                   LossType loss_type, float delta);
 
 // User interface functions
-void learn(int core_id, float x, float y);
-void status();
+int learn(OneCoreCtx *ctx, int core_id, float x, float y);
+void status(OneCoreCtx *ctx);
 void info();
-void fetch_data(int core_id);
+void hex_list(OneCoreCtx *ctx);
+int fetch_data(OneCoreCtx *ctx, int core_id);
+
+// Core management functions
+int core_create(OneCoreCtx *ctx, const char *name, float learning_rate, int epochs);
+AICore* core_get(OneCoreCtx *ctx, int core_id);
+int core_delete(OneCoreCtx *ctx, int core_id);
+int core_lock(OneCoreCtx *ctx, int core_id);
+int core_trylock(OneCoreCtx *ctx, int core_id);
+void core_unlock(OneCoreCtx *ctx, int core_id);
+int train_cores(OneCoreCtx *ctx, int num_cores, int *core_ids);
+int resume_core(OneCoreCtx *ctx, int core_id, const char *filename);
+
+// Published snapshots: lock-free reads of core parameters. One context at
+// a time is attached to the table; publishing from any other is a no-op.
+void snapshot_attach(OneCoreCtx *ctx);
+void snapshot_detach(OneCoreCtx *ctx);
+void snapshot_publish_core(OneCoreCtx *ctx, const AICore *core);
+void snapshot_publish_all(OneCoreCtx *ctx);
+int snapshot_read(int core_id, CoreParams *out);
+int snapshot_core(OneCoreCtx *ctx, int core_id, CoreParams *out);
+int snapshot_share(OneCoreCtx *ctx, const char *name);
+int snapshot_unshare();
+
+// Background training jobs: submit returns a job ID (or -1) at once
+int job_submit(OneCoreCtx *ctx, JobKind kind, const int *core_ids, int count, const char *filename);
+int job_cancel(OneCoreCtx *ctx, int job_id);
+int job_wait(OneCoreCtx *ctx, int job_id);
+int job_wait_all(OneCoreCtx *ctx);
+int job_active(OneCoreCtx *ctx);
+int job_core_busy(OneCoreCtx *ctx, int core_id);
+void job_list(OneCoreCtx *ctx);
+void job_shutdown(OneCoreCtx *ctx);
+
+// Prediction server (Unix socket / localhost TCP)
+int server_start(OneCoreCtx *ctx, const char *path, int workers, int tcp_port);
+int server_stop();
+int server_wait();
+void server_status();
 
 // Block management functions
-void block_clear();
-void block_run();
-void block_delete();
-void block_status();
-void block_config();
-void block_location(int core_id);
+int block_size(OneCoreCtx *ctx, int core_id);
+void block_clear(OneCoreCtx *ctx);
+int block_run(OneCoreCtx *ctx);
+void block_delete(OneCoreCtx *ctx);
+void block_status(OneCoreCtx *ctx);
+void block_config(OneCoreCtx *ctx);
+void block_location(OneCoreCtx *ctx, int core_id);
+
+#pragma GCC visibility pop
 
 #endif
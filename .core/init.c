@@ -4,10 +4,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
+#include <pthread.h>
 
 // Bindings.
 
 #include "handle.h"
+#include "context.h"
+#include "trace.h"
 
 /*
 
@@ -17,29 +21,75 @@
 
 */
 
-// Configuration variables
-#define MAX_CORES 30
+// Configuration variables (MAX_CORES is defined in handle.h)
 #define MAX_ITERATIONS 100
-#define DATA_SIZE 1000
 #define DISK_SIZE 100
 
-// AICore structure defined in handle.h
+// AICore, TrainingData and Dataset structures defined in handle.h
 
-// Data structure for training samples
-typedef struct {
-    unsigned char data_sheet;  // Hexadecimal data sheet for logic control
-    float x;
-    float y;
-} TrainingData;
+// Engine contexts: cores, hex data and settings live in a OneCoreCtx (context.h)
 
-// Global cores array
-AICore cores[MAX_CORES];
-int active_cores = 0;
+// Create an empty context (no cores, fp32 data, default generator, quiet)
+OneCoreCtx *onecore_create() {
+    OneCoreCtx *ctx = aligned_alloc(CTX_CACHE_LINE, sizeof(OneCoreCtx));
+    if (!ctx) {
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(*ctx));
+    for (int i = 0; i < MAX_CORES; i++) {
+        pthread_mutex_init(&ctx->core_locks[i].lock, NULL);
+    }
+    pthread_mutex_init(&ctx->hex_data_lock, NULL);
+    pthread_mutex_init(&ctx->job_lock, NULL);
+    pthread_cond_init(&ctx->job_done, NULL);
+    pthread_mutex_init(&ctx->numa_stats_lock, NULL);
+    ctx->dataset_precision = PRECISION_FP32;
+    ctx->numa_policy = NUMA_REPLICATE;
+    generator_defaults(&ctx->generator);
+    return ctx;
+}
 
-// Global hex data storage for recent training
-#define MAX_HEX_DATA 1000
-unsigned char recent_hex_data[MAX_HEX_DATA];
-int recent_hex_count = 0;
+// Free a context and its cores, cancelling its background jobs first
+void onecore_destroy(OneCoreCtx *ctx) {
+    if (!ctx) {
+        return;
+    }
+    job_shutdown(ctx);
+    checkpoint_release(ctx);
+    snapshot_detach(ctx);
+    for (int i = 0; i < ctx->active_cores; i++) {
+        mlp_free(ctx->cores[i].mlp);
+    }
+    for (int i = 0; i < MAX_CORES; i++) {
+        pthread_mutex_destroy(&ctx->core_locks[i].lock);
+    }
+    pthread_mutex_destroy(&ctx->hex_data_lock);
+    pthread_cond_destroy(&ctx->job_done);
+    pthread_mutex_destroy(&ctx->job_lock);
+    pthread_mutex_destroy(&ctx->numa_stats_lock);
+    free(ctx);
+}
+
+void onecore_set_interactive(OneCoreCtx *ctx, int interactive) {
+    ctx->interactive = interactive;
+}
+
+DataPrecision onecore_precision(const OneCoreCtx *ctx) {
+    return ctx->dataset_precision;
+}
+
+// Storage precision for generated training data ('precision' command)
+void onecore_set_precision(OneCoreCtx *ctx, DataPrecision precision) {
+    ctx->dataset_precision = precision;
+}
+
+GeneratorConfig *onecore_generator(OneCoreCtx *ctx) {
+    return &ctx->generator;
+}
+
+int onecore_core_count(const OneCoreCtx *ctx) {
+    return ctx->active_cores;
+}
 
 // AI Block Functions - Core Logic Components
 
@@ -153,6 +203,23 @@ void ai_block_update(float *w, float *b, float dw, float db, float learning_rate
     *b -= learning_rate * db;
 }
 
+// Single-sample learning block: one gradient step on (x, y), or a
+// streaming update when the core streams (stream.c)
+void ai_block_learn(AICore *core, float x, float y) {
+    if (core->type == CORE_MLP) {
+        mlp_learn(core, x, y);
+        return;
+    }
+    if (core->stream.enabled) {
+        stream_learn(core, x, y);
+        return;
+    }
+    float pred = ai_block_forward(core->weight, core->bias, x);
+    float dw, db;
+    ai_block_gradients(pred, y, x, &dw, &db);
+    ai_block_update(&core->weight, &core->bias, dw, db, core->learning_rate);
+}
+
 // Function to visualize a core's variables as containers
 void visualize_core(AICore *core, float current_loss) {
     printf("╔══════════════════════════════════════════════════════════╗\n");
@@ -212,82 +279,105 @@ void visualize_core(AICore *core, float current_loss) {
     printf("╚══════════════════════════════════════════════════════════╝\n");
 }
 
-// Training block - combines all AI blocks for one core
-int ai_block_train(AICore *core, TrainingData *data, size_t data_size) {
-    printf("Training Core %d (%s)...\n", core->id, core->name);
-    printf("Loss Function: %s | Regularization: %s (lambda=%.6f)\n", 
-           core->loss_type == LOSS_MSE ? "MSE" : 
-           core->loss_type == LOSS_MAE ? "MAE" : "Huber",
-           core->regularization_lambda > 0 ? "Enabled" : "Disabled",
-           core->regularization_lambda);
+// Epoch block - loss and gradient sums over a dataset at the core's current parameters
+void ai_block_epoch(const AICore *core, const Dataset *dataset, EpochSums *sums) {
+    ai_block_select_kernel(core, dataset)(core, dataset, sums);
+}
 
-    // Reset loss history
-    core->loss_count = 0;
+// Step block - average epoch sums, clip and update. Returns the average loss.
+float ai_block_step(AICore *core, const EpochSums *sums) {
+    size_t data_size = sums->count > 0 ? sums->count : 1;
+
+    // Average gradients and loss
+    float avg_dw = sums->dw / data_size;
+    float avg_db = sums->db / data_size;
+    float total_loss = sums->loss / data_size;
+
+    // Clip gradients to prevent explosion (gradient clipping for stability)
+    float max_grad = GRADIENT_CLIP;
+    if (avg_dw > max_grad) avg_dw = max_grad;
+    if (avg_dw < -max_grad) avg_dw = -max_grad;
+    if (avg_db > max_grad) avg_db = max_grad;
+    if (avg_db < -max_grad) avg_db = -max_grad;
+
+    // Update parameters
+    ai_block_update(&core->weight, &core->bias, avg_dw, avg_db, core->learning_rate);
+    return total_loss;
+}
 
-    for (int epoch = 0; epoch < core->epochs; epoch++) {
-        float total_loss = 0.0f;
-        float avg_dw = 0.0f;
-        float avg_db = 0.0f;
-
-        // Forward pass and gradient accumulation
-        for (size_t i = 0; i < data_size; i++) {
-            float pred = ai_block_forward(core->weight, core->bias, data[i].x);
-            
-            // Use new loss calculation with regularization
-            float loss = ai_block_loss_with_regularization(pred, data[i].y, core->weight, 
-                                                          core->bias, core->loss_type, 
-                                                          core->huber_delta, 
-                                                          core->regularization_lambda);
-            total_loss += loss;
-
-            float dw, db;
-            // Use advanced gradient calculation
-            ai_block_gradients_advanced(pred, data[i].y, data[i].x, core->weight, core->bias,
-                                       &dw, &db, core->loss_type, core->huber_delta, 
-                                       core->regularization_lambda);
-
-            // Apply hexadecimal data sheet logic to gradients
-            unsigned char hex = data[i].data_sheet;
-            if (hex & 0x01) dw *= 2.0f;  // Bit 0: Amplify weight gradient
-            if (hex & 0x02) db *= 2.0f;  // Bit 1: Amplify bias gradient
-            if (hex & 0x04) dw = -dw;    // Bit 2: Invert weight gradient
-            if (hex & 0x08) db = -db;    // Bit 3: Invert bias gradient
-            if (hex & 0x10) {            // Bit 4: Scale gradients up
-                dw *= 1.5f;
-                db *= 1.5f;
-            }
-            if (hex & 0x20) {            // Bit 5: Scale gradients down
-                dw *= 0.5f;
-                db *= 0.5f;
-            }
-            if (hex & 0x40) {            // Bit 6: Swap gradients
-                float temp = dw;
-                dw = db;
-                db = temp;
-            }
-            if (hex & 0x80) {            // Bit 7: Zero gradients
-                dw = 0.0f;
-                db = 0.0f;
-            }
+// Control of the training run on this thread (a background job's, or none)
+static _Thread_local TrainControl *train_control;
 
-            avg_dw += dw;
-            avg_db += db;
-        }
+void ai_block_set_control(TrainControl *control) {
+    train_control = control;
+}
+
+TrainControl *ai_block_control() {
+    return train_control;
+}
+
+// Training block - combines all AI blocks for one core.
+// Starts at start_epoch (non-zero when resuming from a checkpoint).
+// Returns -1 if the thread's TrainControl cancelled it.
+int ai_block_train_dataset(OneCoreCtx *ctx, AICore *core, const Dataset *dataset, int start_epoch) {
+    TrainControl *control = train_control;
+    int quiet = control && control->quiet;
+    if (!quiet) {
+        printf("Training Core %d (%s)...\n", core->id, core->name);
+        printf("Loss Function: %s | Regularization: %s (lambda=%.6f)\n", 
+               core->loss_type == LOSS_MSE ? "MSE" : 
+               core->loss_type == LOSS_MAE ? "MAE" : "Huber",
+               core->regularization_lambda > 0 ? "Enabled" : "Disabled",
+               core->regularization_lambda);
+    }
+    if (core->type == CORE_MLP && !quiet) {
+        char model[128];
+        mlp_describe(core->mlp, model, sizeof(model));
+        printf("Model: MLP %s\n", model);
+    }
+
+    // Reset loss history (a resumed run keeps the epochs already recorded)
+    if (start_epoch <= 0) {
+        start_epoch = 0;
+        core->loss_count = 0;
+    } else {
+        if (!quiet) printf("Resuming at epoch %d/%d\n", start_epoch, core->epochs);
+        core->loss_count = start_epoch < 100 ? start_epoch : 100;
+    }
 
-        // Average gradients and loss
-        avg_dw /= data_size;
-        avg_db /= data_size;
-        total_loss /= data_size;
+    // Loss type, regularization and data sheet use are fixed for the whole run;
+    // MSE epochs run from per-sheet sums gathered here in one pass
+    EpochKernel epoch_kernel = ai_block_select_kernel(core, dataset);
+    int grouped = ai_block_uses_sheet_stats(core) && core->epochs - start_epoch > 1;
+    SheetStats stats;
+    if (grouped) {
+        TRACE_BEGIN(TRACE_SHEET_STATS, core->id, (int64_t)dataset->size);
+        ai_block_sheet_stats(dataset, &stats);
+        TRACE_END(TRACE_SHEET_STATS, core->id, (int64_t)dataset->size);
+    }
+    memory_core_dataset(ctx, core->id, dataset_bytes(dataset));
 
-        // Clip gradients to prevent explosion (gradient clipping for stability)
-        float max_grad = 5.0f;
-        if (avg_dw > max_grad) avg_dw = max_grad;
-        if (avg_dw < -max_grad) avg_dw = -max_grad;
-        if (avg_db > max_grad) avg_db = max_grad;
-        if (avg_db < -max_grad) avg_db = -max_grad;
+    int epoch;
+    for (epoch = start_epoch; epoch < core->epochs; epoch++) {
+        // Cooperative cancellation: stop between epochs, never inside one
+        if (control && atomic_load_explicit(&control->cancel, memory_order_relaxed)) {
+            break;
+        }
 
-        // Update parameters
-        ai_block_update(&core->weight, &core->bias, avg_dw, avg_db, core->learning_rate);
+        TRACE_BEGIN(TRACE_EPOCH, core->id, epoch + 1);
+        float total_loss;
+        if (core->type == CORE_MLP) {
+            total_loss = mlp_epoch(core, dataset);
+        } else {
+            EpochSums sums;
+            TRACE_BEGIN(TRACE_GRADIENTS, core->id, epoch + 1);
+            if (grouped) ai_block_epoch_grouped(core, &stats, &sums);
+            else epoch_kernel(core, dataset, &sums);
+            TRACE_END(TRACE_GRADIENTS, core->id, epoch + 1);
+            TRACE_BEGIN(TRACE_UPDATE, core->id, epoch + 1);
+            total_loss = ai_block_step(core, &sums);
+            TRACE_END(TRACE_UPDATE, core->id, epoch + 1);
+        }
 
         // Store loss history (with safety checks)
         if (epoch < 100) {
@@ -300,31 +390,75 @@ int ai_block_train(AICore *core, TrainingData *data, size_t data_size) {
             core->loss_count++;
         }
 
+        // Hand a copy to the background checkpoint writer when due, and let
+        // readers see the completed epoch
+        checkpoint_after_epoch(ctx, core, epoch + 1);
+        snapshot_publish_core(ctx, core);
+        TRACE_END(TRACE_EPOCH, core->id, epoch + 1);
+        if (control) {
+            atomic_fetch_add_explicit(&control->epochs_done, 1, memory_order_relaxed);
+        }
+        if (quiet) {
+            continue;
+        }
+
         // Visualize the core every 5 epochs
-        if ((epoch + 1) % 5 == 0 || epoch == 0) {
+        if (ctx->interactive && !(control && control->headless) && ((epoch + 1) % 5 == 0 || epoch == 0)) {
+            TRACE_BEGIN(TRACE_VISUALIZE, core->id, epoch + 1);
             printf("\033[2J\033[H"); // Clear screen
             visualize_core(core, total_loss);
             printf("Epoch: %d/%d\n", epoch + 1, core->epochs);
+            TRACE_END(TRACE_VISUALIZE, core->id, epoch + 1);
         }
 
         // Print progress
-        if ((epoch + 1) % 10 == 0) {
+        if ((epoch + 1) % 10 == 0 && core->type == CORE_MLP) {
+            printf("  Epoch %d: Loss = %.4f\n", epoch + 1, total_loss);
+        } else if ((epoch + 1) % 10 == 0) {
             printf("  Epoch %d: Loss = %.4f, w = %.4f, b = %.4f\n",
                    epoch + 1, total_loss, core->weight, core->bias);
         }
     }
 
+    stream_restart(core);
+    if (epoch < core->epochs) {
+        memory_core_dataset(ctx, core->id, 0);
+        printf("Core %d training cancelled at epoch %d/%d\n", core->id, epoch, core->epochs);
+        return -1;
+    }
+
     core->trained = 1;
-    printf("Core %d training completed!\n", core->id);
+    memory_core_dataset(ctx, core->id, 0);
+    snapshot_publish_core(ctx, core);
+    if (!quiet) printf("Core %d training completed!\n", core->id);
     return 0;
 }
 
+// Training block for array-of-structs samples
+int ai_block_train_from(OneCoreCtx *ctx, AICore *core, TrainingData *data, size_t data_size, int start_epoch) {
+    Dataset dataset;
+    if (dataset_from_training_data(&dataset, data, data_size, PRECISION_FP32) != 0) {
+        printf("Failed to allocate training data.\n");
+        return -1;
+    }
+    int result = ai_block_train_dataset(ctx, core, &dataset, start_epoch);
+    dataset_free(&dataset);
+    return result;
+}
+
+int ai_block_train(OneCoreCtx *ctx, AICore *core, TrainingData *data, size_t data_size) {
+    return ai_block_train_from(ctx, core, data, data_size, 0);
+}
+
 // Prediction block
 float ai_block_predict(AICore *core, float x) {
     if (!core->trained) {
         printf("Warning: Core %d not trained yet!\n", core->id);
         return 0.0f;
     }
+    if (core->type == CORE_MLP) {
+        return mlp_predict(core->mlp, x);
+    }
     return ai_block_forward(core->weight, core->bias, x);
 }
 
@@ -341,19 +475,20 @@ void ai_block_load_variables(AICore *core, float w, float b, float lr, int epoch
     core->bias = b;
     core->learning_rate = lr;
     core->epochs = epochs;
+    stream_restart(core);
 }
 
 // Core Management Functions
 
 // Create a new core
-int core_create(const char *name, float learning_rate, int epochs) {
-    if (active_cores >= MAX_CORES) {
+int core_create(OneCoreCtx *ctx, const char *name, float learning_rate, int epochs) {
+    if (ctx->active_cores >= MAX_CORES) {
         printf("Maximum cores reached!\n");
         return -1;
     }
 
-    AICore *core = &cores[active_cores];
-    core->id = active_cores + 1;
+    AICore *core = &ctx->cores[ctx->active_cores];
+    core->id = ctx->active_cores + 1;
     strncpy(core->name, name, sizeof(core->name) - 1);
     core->weight = 0.0f;
     core->bias = 0.0f;
@@ -364,58 +499,106 @@ int core_create(const char *name, float learning_rate, int epochs) {
     core->loss_type = LOSS_MSE;  // Default loss function
     core->regularization_lambda = 0.0f;  // No regularization by default
     core->huber_delta = 1.0f;  // Default Huber delta
+    core->type = CORE_LINEAR;
+    core->mlp = NULL;
+    memset(&core->stream, 0, sizeof(core->stream));
 
     printf("Created Core %d: %s\n", core->id, core->name);
-    return active_cores++;
+    ctx->active_cores++;
+    snapshot_publish_core(ctx, core);
+    return ctx->active_cores - 1;
+}
+
+// Hold every core lock while the cores are renumbered, so a server LEARN
+// (which locks by ID) never updates a core that moved under it
+static void core_lock_all(OneCoreCtx *ctx) {
+    for (int i = 1; i <= MAX_CORES; i++) {
+        core_lock(ctx, i);
+    }
+}
+
+static void core_unlock_all(OneCoreCtx *ctx) {
+    for (int i = MAX_CORES; i >= 1; i--) {
+        core_unlock(ctx, i);
+    }
 }
 
 // Delete a core
-void core_delete(int core_id) {
-    if (core_id < 1 || core_id > active_cores) {
+int core_delete(OneCoreCtx *ctx, int core_id) {
+    if (core_id < 1 || core_id > ctx->active_cores) {
         printf("Invalid core ID!\n");
-        return;
+        return -1;
     }
+    // Deleting renumbers the cores under any running job
+    if (job_active(ctx)) {
+        printf("Training jobs are running; wait for or cancel them first.\n");
+        return -1;
+    }
+
+    core_lock_all(ctx);
+    AICore *cores = ctx->cores;
+    mlp_free(cores[core_id - 1].mlp);
 
     // Shift cores down
-    for (int i = core_id - 1; i < active_cores - 1; i++) {
+    for (int i = core_id - 1; i < ctx->active_cores - 1; i++) {
         cores[i] = cores[i + 1];
         cores[i].id = i + 1;
     }
-    active_cores--;
+    memory_core_deleted(ctx, core_id, ctx->active_cores);
+    ctx->active_cores--;
+    snapshot_publish_all(ctx);
+    core_unlock_all(ctx);
     printf("Deleted Core %d\n", core_id);
+    return 0;
 }
 
 // Get core by ID
-AICore* core_get(int core_id) {
-    if (core_id < 1 || core_id > active_cores) {
+AICore* core_get(OneCoreCtx *ctx, int core_id) {
+    if (core_id < 1 || core_id > ctx->active_cores) {
         return NULL;
     }
-    return &cores[core_id - 1];
+    return &ctx->cores[core_id - 1];
 }
 
+// Lock a core against concurrent writers. Returns -1 if the ID is invalid.
+int core_lock(OneCoreCtx *ctx, int core_id) {
+    if (core_id < 1 || core_id > MAX_CORES) {
+        return -1;
+    }
+    pthread_mutex_lock(&ctx->core_locks[core_id - 1].lock);
+    return 0;
+}
 
-// Block functions for user interface (from handle.h)
+// Lock a core only if no writer holds it. Returns 0 when locked.
+int core_trylock(OneCoreCtx *ctx, int core_id) {
+    if (core_id < 1 || core_id > MAX_CORES) {
+        return -1;
+    }
+    return pthread_mutex_trylock(&ctx->core_locks[core_id - 1].lock) == 0 ? 0 : -1;
+}
 
+void core_unlock(OneCoreCtx *ctx, int core_id) {
+    if (core_id >= 1 && core_id <= MAX_CORES) {
+        pthread_mutex_unlock(&ctx->core_locks[core_id - 1].lock);
+    }
+}
 
-// Block size on disk.
 
-void block_size(int id_core) {
+// Block functions for user interface (from handle.h)
+
 
-    AICore *core = core_get(id_core);
+// Block size on disk.
 
-    // This command finds the size of 'target_function' in the compiled binary
-    // Note: The binary must be compiled with symbols (not stripped)
-    printf("Fetching function size from symbol table...\n");
-    
-    // Replace 'a.out' with your executable name
-    system("nm --print-size --size-sort onecoreai | grep core");
+int block_size(OneCoreCtx *ctx, int id_core) {
+    // Accounted in-process (memory.c): core data, datasets, arenas and RSS
+    return memory_report_core(ctx, id_core);
 }
 
 // Block disk and hardware location.
 
-void block_location(int id_arg) {
+void block_location(OneCoreCtx *ctx, int id_arg) {
 
-    AICore *core = core_get(id_arg);
+    AICore *core = core_get(ctx, id_arg);
 
     // This is the 'address' stored inside the pointer (Location of Data)
     printf("Core storage address: %p\n", (void*)core);
@@ -425,98 +608,176 @@ void block_location(int id_arg) {
 }
 
 // Clear block from variables.
-void block_clear() {
-    active_cores = 0;
+void block_clear(OneCoreCtx *ctx) {
+    if (job_active(ctx)) {
+        printf("Training jobs are running; wait for or cancel them first.\n");
+        return;
+    }
+    core_lock_all(ctx);
+    for (int i = 0; i < ctx->active_cores; i++) {
+        mlp_free(ctx->cores[i].mlp);
+        ctx->cores[i].mlp = NULL;
+    }
+    ctx->active_cores = 0;
+    memory_cores_cleared(ctx);
+    snapshot_publish_all(ctx);
+    core_unlock_all(ctx);
     printf("All cores cleared.\n");
 }
 
-// Run a block (train a core).
-void block_run() {
-    if (active_cores == 0) {
-        printf("No cores available. Create a core first.\n");
-        return;
+// Generate the run's training data (y = 2*x + 1 + noise by default, 'gen samples' of them,
+// see 'gen'), stored at the context's precision in the run's arena, or implicit: computed
+// from the sample index as it is read, with nothing stored. On success *arena is the run's
+// arena, to be ended after the data is freed.
+static int generate_training_data(OneCoreCtx *ctx, Dataset *data, Arena **arena) {
+    GeneratorConfig config = ctx->generator;
+    size_t size = config.samples;
+    *arena = arena_run_begin(config.implicit ? 0 : dataset_arena_size(size, ctx->dataset_precision));
+    if (config.implicit) {
+        generator_implicit(data, &config, 0, size);
+    } else {
+        if (dataset_alloc_in(data, size, ctx->dataset_precision, *arena) != 0) {
+            arena_run_end(*arena);
+            printf("Failed to allocate training data.\n");
+            return -1;
+        }
+        generator_fill(data, &config);
     }
 
-    // Generate training data: y = 2*x + 1 + noise
-    TrainingData *data = malloc(DATA_SIZE * sizeof(TrainingData));
-    srand(time(NULL));
+    // Store hex data for listing (script mode may train several cores at once)
+    pthread_mutex_lock(&ctx->hex_data_lock);
+    ctx->recent_hex_count = 0;
+    while (ctx->recent_hex_count < MAX_HEX_DATA) {
+        DatasetChunk chunk;
+        size_t count = dataset_chunk(data, ctx->recent_hex_count, MAX_HEX_DATA - ctx->recent_hex_count, &chunk);
+        if (count == 0) break;
+        memcpy(ctx->recent_hex_data + ctx->recent_hex_count, chunk.data_sheet, count);
+        ctx->recent_hex_count += (int)count;
+    }
+    pthread_mutex_unlock(&ctx->hex_data_lock);
 
-    // Reset hex data storage
-    recent_hex_count = 0;
+    return 0;
+}
 
-    for (size_t i = 0; i < DATA_SIZE; i++) {
-        data[i].x = (float)i / 100.0f;  // Scale to 0-10 range
-        data[i].y = 2.0f * data[i].x + 1.0f + ((float)rand() / RAND_MAX - 0.5f) * 2.0f;
-        data[i].data_sheet = (unsigned char)(rand() % 256);  // Generate hexadecimal data sheet
+// Run a block (train a core).
+int block_run(OneCoreCtx *ctx) {
+    if (ctx->active_cores == 0) {
+        printf("No cores available. Create a core first.\n");
+        return -1;
+    }
 
-        // Store hex data for listing
-        if (recent_hex_count < MAX_HEX_DATA) {
-            recent_hex_data[recent_hex_count++] = data[i].data_sheet;
-        }
+    // Everything the run allocates comes from the arena and is released at once
+    Arena *arena;
+    Dataset data;
+    if (generate_training_data(ctx, &data, &arena) != 0) {
+        return -1;
     }
 
-    // Train all cores
-    for (int i = 0; i < active_cores; i++) {
-        ai_block_train(&cores[i], data, DATA_SIZE);
+    // Train all cores (in parallel on NUMA-pinned workers when there are CPUs for it)
+    int core_ids[MAX_CORES];
+    for (int i = 0; i < ctx->active_cores; i++) {
+        core_ids[i] = i + 1;
     }
+    int result = numa_train_cores(ctx, core_ids, ctx->active_cores, &data) == 0 ? 0 : -1;
 
-    free(data);
+    dataset_free(&data);
+    arena_run_end(arena);
+    return result;
 }
 
 // Train specific cores
-void train_cores(int num_cores, int *core_ids) {
+int train_cores(OneCoreCtx *ctx, int num_cores, int *core_ids) {
     if (num_cores == 0) {
         printf("No cores to train.\n");
-        return;
+        return -1;
     }
 
-    // Generate training data: y = 2*x + 1 + noise
-    TrainingData *data = malloc(DATA_SIZE * sizeof(TrainingData));
-    srand(time(NULL));
+    Arena *arena;
+    Dataset data;
+    if (generate_training_data(ctx, &data, &arena) != 0) {
+        return -1;
+    }
 
-    // Reset hex data storage
-    recent_hex_count = 0;
+    // Train specified cores
+    int result = numa_train_cores(ctx, core_ids, num_cores, &data) == 0 ? 0 : -1;
 
-    for (size_t i = 0; i < DATA_SIZE; i++) {
-        data[i].x = (float)i / 100.0f;  // Scale to 0-10 range
-        data[i].y = 2.0f * data[i].x + 1.0f + ((float)rand() / RAND_MAX - 0.5f) * 2.0f;
-        data[i].data_sheet = (unsigned char)(rand() % 256);  // Generate hexadecimal data sheet
+    dataset_free(&data);
+    arena_run_end(arena);
+    return result;
+}
 
-        // Store hex data for listing
-        if (recent_hex_count < MAX_HEX_DATA) {
-            recent_hex_data[recent_hex_count++] = data[i].data_sheet;
-        }
+// Resume training a core from a checkpoint file at its saved epoch
+int resume_core(OneCoreCtx *ctx, int core_id, const char *filename) {
+    AICore *core = core_get(ctx, core_id);
+    if (!core) {
+        printf("Invalid core ID: %d\n", core_id);
+        return -1;
+    }
+    if (core->type != CORE_LINEAR) {
+        printf("Core %d is an MLP core; checkpoints hold linear parameters only.\n", core_id);
+        return -1;
     }
 
-    // Train specified cores
-    for (int i = 0; i < num_cores; i++) {
-        int core_id = core_ids[i];
-        AICore *core = core_get(core_id);
-        if (core) {
-            ai_block_train(core, data, DATA_SIZE);
-        } else {
-            printf("Invalid core ID: %d\n", core_id);
-        }
+    core_lock(ctx, core_id);
+    int epoch = 0;
+    if (ai_block_load_checkpoint(ctx, core_id, filename, &epoch) != 0) {
+        core_unlock(ctx, core_id);
+        printf("Failed to load checkpoint: %s\n", filename);
+        return -1;
+    }
+    if (epoch >= core->epochs) {
+        core_unlock(ctx, core_id);
+        printf("Core %d already completed %d/%d epochs.\n", core_id, epoch, core->epochs);
+        return 0;
+    }
+
+    Arena *arena;
+    Dataset data;
+    if (generate_training_data(ctx, &data, &arena) != 0) {
+        core_unlock(ctx, core_id);
+        return -1;
     }
+    ai_block_train_dataset(ctx, core, &data, epoch);
+    core_unlock(ctx, core_id);
 
-    free(data);
+    dataset_free(&data);
+    arena_run_end(arena);
+    return 0;
 }
 
 // Delete a block.
-void block_delete() {
+void block_delete(OneCoreCtx *ctx) {
     // For simplicity, delete the last core
-    if (active_cores > 0) {
-        core_delete(active_cores);
+    if (ctx->active_cores > 0) {
+        core_delete(ctx, ctx->active_cores);
     }
 }
 
 // Display output of block activity.
-void block_status() {
+void block_status(OneCoreCtx *ctx) {
     printf("\n=== OneCoreAI Status ===\n");
-    printf("Active Cores: %d\n\n", active_cores);
+    printf("Active Cores: %d\n\n", ctx->active_cores);
+
+    for (int i = 0; i < ctx->active_cores; i++) {
+        AICore *core = &ctx->cores[i];
+
+        // A core a job is training, or one whose lock another command holds
+        // (a learn request, a checkpoint copy), is shown from its published snapshot
+        int job_id = job_core_busy(ctx, core->id);
+        if (job_id || core_trylock(ctx, core->id) != 0) {
+            CoreParams params;
+            snapshot_core(ctx, core->id, &params);
+            printf("Core %d (%s):\n", core->id, core->name);
+            if (job_id) printf("  Training: job %d\n", job_id);
+            else printf("  Busy\n");
+            if (params.type == CORE_LINEAR) {
+                printf("  Weight: %.4f, Bias: %.4f (%s)\n", params.weight, params.bias,
+                       job_id ? "last completed epoch" : "last published");
+            }
+            printf("\n");
+            continue;
+        }
 
-    for (int i = 0; i < active_cores; i++) {
-        AICore *core = &cores[i];
         const char *loss_type_str = core->loss_type == LOSS_MSE ? "MSE" : 
                                    core->loss_type == LOSS_MAE ? "MAE" : "Huber";
         
@@ -525,6 +786,14 @@ void block_status() {
         printf("  Loss Function: %s\n", loss_type_str);
         printf("  L2 Regularization: %.6f %s\n", core->regularization_lambda, 
                core->regularization_lambda > 0 ? "(enabled)" : "(disabled)");
+        if (core->type == CORE_MLP) {
+            char model[128];
+            mlp_describe(core->mlp, model, sizeof(model));
+            printf("  Model: MLP %s\n", model);
+        }
+        if (core->stream.enabled && core->type == CORE_LINEAR) {
+            stream_describe(core);
+        }
         
         if (core->trained) {
             printf("  Weight: %.4f, Bias: %.4f\n", core->weight, core->bias);
@@ -538,20 +807,26 @@ void block_status() {
                 }
             }
         }
+        core_unlock(ctx, core->id);
         printf("\n");
     }
+
+    int jobs = job_active(ctx);
+    if (jobs > 0) {
+        printf("Background jobs running: %d (see 'jobs')\n", jobs);
+    }
 }
 
 // Change block variables.
-void block_config() {
+void block_config(OneCoreCtx *ctx) {
 
     // Block disk size configuration.
 
 
 
     // For simplicity, reconfigure the first core
-    if (active_cores > 0) {
-        AICore *core = &cores[0];
+    if (ctx->active_cores > 0) {
+        AICore *core = &ctx->cores[0];
         core->learning_rate = 0.02f;  // Example change
         core->epochs = 200;
         printf("Reconfigured Core %d\n", core->id);
@@ -559,35 +834,49 @@ void block_config() {
 }
 
 // Learn machine blocks for specific core.
-void learn(int core_id, float x, float y) {
-    AICore *core = core_get(core_id);
+int learn(OneCoreCtx *ctx, int core_id, float x, float y) {
+    AICore *core = core_get(ctx, core_id);
     if (core) {
-        float pred = ai_block_forward(core->weight, core->bias, x);
-        float dw, db;
-        ai_block_gradients(pred, y, x, &dw, &db);
-        ai_block_update(&core->weight, &core->bias, dw, db, core->learning_rate);
-        printf("Trained Core %d on sample (%.2f, %.2f)\n", core_id, x, y);
-    } else {
-        printf("Invalid core ID: %d\n", core_id);
+        core_lock(ctx, core_id);
+        int drifting = core->stream.drifting;
+        ai_block_learn(core, x, y);
+        snapshot_publish_core(ctx, core);
+        if (core->stream.enabled && core->type == CORE_LINEAR) {
+            printf("Trained Core %d on sample (%.2f, %.2f): w=%.4f, b=%.4f, window loss %.6f\n", core_id, x, y,
+                   core->weight, core->bias, stream_window_loss(core));
+            if (core->stream.drifting && !drifting) {
+                printf("Drift alert: Core %d window loss above %.6f\n", core_id, core->stream.alert);
+            }
+        } else {
+            printf("Trained Core %d on sample (%.2f, %.2f)\n", core_id, x, y);
+        }
+        core_unlock(ctx, core_id);
+        return 0;
     }
+    printf("Invalid core ID: %d\n", core_id);
+    return -1;
 }
 
 // Fetch learned variables from specific core.
-void fetch_data(int core_id) {
-    AICore *core = core_get(core_id);
-    if (core) {
-        float w, b, lr;
-        int epochs;
-        ai_block_extract_variables(core, &w, &b, &lr, &epochs);
-        printf("Core %d Variables: w=%.4f, b=%.4f, lr=%.4f, epochs=%d\n", core_id, w, b, lr, epochs);
-    } else {
-        printf("Invalid core ID: %d\n", core_id);
+// Reads the published snapshot, so a core that is training gives its last completed epoch.
+int fetch_data(OneCoreCtx *ctx, int core_id) {
+    CoreParams params;
+    if (snapshot_core(ctx, core_id, &params) == 0) {
+        if (params.type != CORE_LINEAR) {
+            printf("Core %d is an MLP core; it has no w and b.\n", core_id);
+            return -1;
+        }
+        printf("Core %d Variables: w=%.4f, b=%.4f, lr=%.4f, epochs=%d\n", core_id,
+               params.weight, params.bias, params.learning_rate, params.epochs);
+        return 0;
     }
+    printf("Invalid core ID: %d\n", core_id);
+    return -1;
 }
 
 // Program diagnostic functions.
-void status() {
-    block_status();
+void status(OneCoreCtx *ctx) {
+    block_status(ctx);
 }
 
 void info() {
@@ -611,10 +900,16 @@ void info() {
 }
 
 // Display hexadecimal data list from recent training
-void hex_list() {
+void hex_list(OneCoreCtx *ctx) {
     printf("\n=== Recent Training Hex Data ===\n");
     printf("Hex values used in the last training session:\n\n");
 
+    pthread_mutex_lock(&ctx->hex_data_lock);
+    int recent_hex_count = ctx->recent_hex_count;
+    unsigned char recent_hex_data[MAX_HEX_DATA];
+    memcpy(recent_hex_data, ctx->recent_hex_data, recent_hex_count);
+    pthread_mutex_unlock(&ctx->hex_data_lock);
+
     if (recent_hex_count == 0) {
         printf("No recent training data available.\n");
         printf("Run 'run' or 'train <core_id>' to generate hex data.\n");
@@ -645,145 +940,3 @@ void hex_list() {
     printf("Bit 6: Swap weight and bias gradients\n");
     printf("Bit 7: Zero gradients\n");
 }
-
-int main(int argc, char *argv[]) {
-    printf("Welcome to OneCoreAI - Multiple AI Core Blocks System\n");
-    printf("Type 'help' for available commands.\n\n");
-
-    char command[256];
-    char arg1[64], arg2[64], arg3[64], arg4[64];
-
-    while (1) {
-        printf("OneCoreAI> ");
-        fflush(stdout);
-
-        if (fgets(command, sizeof(command), stdin) == NULL) {
-            break;
-        }
-
-        // Remove newline character
-        command[strcspn(command, "\n")] = 0;
-
-        // Parse command and arguments
-        int args_count = sscanf(command, "%s %s %s %s", arg1, arg2, arg3, arg4);
-
-        if (strcmp(arg1, "exit") == 0 || strcmp(arg1, "quit") == 0) {
-            break;
-        } else if (strcmp(arg1, "help") == 0) {
-            printf("\nAvailable Commands:\n");
-            printf("  create <name> <lr> <epochs>  - Create a new AI core\n");
-            printf("  run                          - Train all cores (shows visualization)\n");
-            printf("  status                       - Show status of all cores\n");
-            printf("  predict <core_id> <x>        - Make prediction with specific core\n");
-            printf("  delete <core_id>             - Delete a specific core\n");
-            printf("  size <core_id>               - Disk block size.\n");
-            printf("  location <core_id>           - Block disk location\n");
-            printf("  clear                        - Clear all cores\n");
-            printf("  config <core_id> <lr> <epochs> - Configure a core\n");
-            printf("  train <core_id> [core_id2] ... - Train specific cores\n");
-            printf("  learn <core_id> <x> <y>      - Train specific core on single sample\n");
-            printf("  fetch <core_id>              - Extract variables from specific core\n");
-            printf("  setloss <core_id> <type>     - Set loss function (0=MSE, 1=MAE, 2=Huber)\n");
-            printf("  setreg <core_id> <lambda>    - Set L2 regularization coefficient\n");
-            printf("  hexlist                      - Display hex data from recent training\n");
-            printf("  info                         - Show system information\n");
-            printf("  help                         - Show this help message\n");
-            printf("  exit                         - Exit the program\n\n");
-        } else if (strcmp(arg1, "create") == 0 && args_count >= 4) {
-            float lr = atof(arg3);
-            int epochs = atoi(arg4);
-            core_create(arg2, lr, epochs);
-        } else if (strcmp(arg1, "run") == 0) {
-            block_run();
-        } else if (strcmp(arg1, "status") == 0) {
-            block_status();
-        } else if (strcmp(arg1, "predict") == 0 && args_count >= 4) {
-            int core_id = atoi(arg2);
-            float x = atof(arg3);
-            float y = atof(arg4);
-            AICore *core = core_get(core_id);
-            if (core) {
-                float pred = ai_block_predict(core, x);
-                printf("Core %d prediction for x=%.2f: %.4f\n", core_id, x, pred);
-            } else {
-                printf("Invalid core ID: %d\n", core_id);
-            }
-        } else if (strcmp(arg1, "delete") == 0 && args_count >= 2) {
-            int core_id = atoi(arg2);
-            core_delete(core_id);
-        } else if (strcmp(arg1, "clear") == 0) {
-            block_clear();
-        } else if (strcmp(arg1, "location") == 0) {
-            int core_id = atoi(arg2);
-            block_location(core_id);
-        } else if (strcmp(arg1, "size") == 0) {
-            int core_id = atoi(arg2);
-            block_size(core_id);
-        } else if (strcmp(arg1, "config") == 0 && args_count >= 4) {
-            int core_id = atoi(arg2);
-            AICore *core = core_get(core_id);
-            if (core) {
-                core->learning_rate = atof(arg3);
-                core->epochs = atoi(arg4);
-                printf("Reconfigured Core %d: lr=%.4f, epochs=%d\n", core_id, core->learning_rate, core->epochs);
-            } else {
-                printf("Invalid core ID: %d\n", core_id);
-            }
-        } else if (strcmp(arg1, "train") == 0 && args_count >= 2) {
-            int core_ids[30];
-            int count = 0;
-            if (args_count >= 2) core_ids[count++] = atoi(arg2);
-            if (args_count >= 3) core_ids[count++] = atoi(arg3);
-            if (args_count >= 4) core_ids[count++] = atoi(arg4);
-            train_cores(count, core_ids);
-        
-        } else if (strcmp(arg1, "learn") == 0 && args_count >= 4) {
-            int core_id = atoi(arg2);
-            float x = atof(arg3);
-            float y = atof(arg4);
-            learn(core_id, x, y);
-        } else if (strcmp(arg1, "fetch") == 0 && args_count >= 2) {
-            fetch_data(atoi(arg2));
-        } else if (strcmp(arg1, "setloss") == 0 && args_count >= 3) {
-            int core_id = atoi(arg2);
-            int loss_type = atoi(arg3);
-            AICore *core = core_get(core_id);
-            if (core) {
-                if (loss_type >= 0 && loss_type <= 2) {
-                    core->loss_type = (LossType)loss_type;
-                    const char *loss_names[] = {"MSE", "MAE", "Huber"};
-                    printf("Core %d loss function set to: %s\n", core_id, loss_names[loss_type]);
-                } else {
-                    printf("Invalid loss type! Valid options: 0=MSE, 1=MAE, 2=Huber\n");
-                }
-            } else {
-                printf("Invalid core ID: %d\n", core_id);
-            }
-        } else if (strcmp(arg1, "setreg") == 0 && args_count >= 3) {
-            int core_id = atoi(arg2);
-            float lambda = atof(arg3);
-            AICore *core = core_get(core_id);
-            if (core) {
-                if (lambda >= 0) {
-                    core->regularization_lambda = lambda;
-                    printf("Core %d L2 regularization set to: %.6f\n", core_id, lambda);
-                } else {
-                    printf("Regularization coefficient must be non-negative!\n");
-                }
-            } else {
-                printf("Invalid core ID: %d\n", core_id);
-            }
-        } else if (strcmp(arg1, "hexlist") == 0) {
-            hex_list();
-        } else if (strcmp(arg1, "info") == 0) {
-            info();
-        } else if (strlen(arg1) > 0) {
-            printf("Unknown command: %s\n", arg1);
-            printf("Type 'help' for available commands.\n");
-        }
-        printf("\n");
-    }
-
-    printf("Goodbye!\n");
-    return 0;
-}
@@ -0,0 +1,285 @@
+/*
+
+    OneCoreAI - Background Jobs
+
+    `train`, `run` and `resume` can run as jobs on their own threads while
+    the prompt keeps taking commands. Each job owns a TrainControl that the
+    training loop checks once per epoch: `cancel` sets its flag and every
+    core of the job stops at the next epoch boundary, keeping the
+    parameters of the last completed epoch. Readers (`predict`, `fetch`,
+    `status`) use the snapshot published after each epoch instead of
+    waiting for the core lock.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "handle.h"
+#include "context.h"
+#include "trace.h"
+
+static const char *job_state_names[] = { "queued", "running", "done", "failed", "cancelled" };
+static const char *job_kind_names[] = { "train", "run", "resume" };
+
+static double job_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int job_finished(const Job *job) {
+    return atomic_load(&job->state) >= JOB_DONE;
+}
+
+// Find a job by ID (caller holds job_lock)
+static Job *job_find(OneCoreCtx *ctx, int job_id) {
+    for (int i = 0; i < MAX_JOBS; i++) {
+        if (job_id > 0 && ctx->jobs[i].id == job_id) {
+            return &ctx->jobs[i];
+        }
+    }
+    return NULL;
+}
+
+// Does the job train core_id? (caller holds job_lock)
+static int job_has_core(const Job *job, int core_id) {
+    if (job->kind == JOB_RUN) {
+        return 1;
+    }
+    for (int i = 0; i < job->core_count; i++) {
+        if (job->core_ids[i] == core_id) return 1;
+    }
+    return 0;
+}
+
+static void *job_thread(void *arg) {
+    Job *job = arg;
+    OneCoreCtx *ctx = job->ctx;
+
+    atomic_store(&job->state, JOB_RUNNING);
+    ai_block_set_control(&job->control);
+    trace_name_thread("job %d", job->id);
+    int result;
+    switch (job->kind) {
+        case JOB_RUN:
+            result = block_run(ctx);
+            break;
+        case JOB_RESUME:
+            result = resume_core(ctx, job->core_ids[0], job->filename);
+            break;
+        default:
+            result = train_cores(ctx, job->core_count, job->core_ids);
+            break;
+    }
+    ai_block_set_control(NULL);
+
+    // Nothing touches the job after the lock is released: its slot may be reused
+    pthread_mutex_lock(&ctx->job_lock);
+    job->result = result;
+    job->seconds = job_now() - job->started;
+    JobState state = atomic_load(&job->control.cancel) ? JOB_CANCELLED : (result == 0 ? JOB_DONE : JOB_FAILED);
+    atomic_store(&job->state, state);
+    ctx->jobs_active--;
+    printf("[job %d] %s %s in %.2f s\n", job->id, job_kind_names[job->kind], job_state_names[state], job->seconds);
+    fflush(stdout);
+    pthread_cond_broadcast(&ctx->job_done);
+    pthread_mutex_unlock(&ctx->job_lock);
+    return NULL;
+}
+
+// Start a training job on its own thread. Returns the job ID, or -1.
+int job_submit(OneCoreCtx *ctx, JobKind kind, const int *core_ids, int count, const char *filename) {
+    if (kind != JOB_RUN && count < 1) {
+        printf("No cores to train.\n");
+        return -1;
+    }
+    if (count > MAX_CORES) count = MAX_CORES;
+
+    pthread_mutex_lock(&ctx->job_lock);
+
+    // A free slot, or the oldest finished job's
+    Job *job = NULL;
+    for (int i = 0; i < MAX_JOBS; i++) {
+        Job *slot = &ctx->jobs[i];
+        if (slot->id == 0) {
+            job = slot;
+            break;
+        }
+        if (job_finished(slot) && (!job || slot->id < job->id)) {
+            job = slot;
+        }
+    }
+    if (!job) {
+        pthread_mutex_unlock(&ctx->job_lock);
+        printf("Too many jobs running (%d).\n", MAX_JOBS);
+        return -1;
+    }
+
+    memset(job, 0, sizeof(*job));
+    job->ctx = ctx;
+    job->kind = kind;
+    if (kind != JOB_RUN) {
+        memcpy(job->core_ids, core_ids, count * sizeof(int));
+        job->core_count = count;
+    }
+    if (filename) {
+        snprintf(job->filename, sizeof(job->filename), "%s", filename);
+    }
+    for (int i = 1; i <= ctx->active_cores; i++) {
+        if (job_has_core(job, i)) job->total_epochs += ctx->cores[i - 1].epochs;
+    }
+    job->control.quiet = 1;
+    job->started = job_now();
+    job->id = ++ctx->next_job_id;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    ctx->jobs_active++;
+    if (pthread_create(&thread, &attr, job_thread, job) != 0) {
+        ctx->jobs_active--;
+        job->id = 0;
+        pthread_attr_destroy(&attr);
+        pthread_mutex_unlock(&ctx->job_lock);
+        printf("Failed to start a job thread.\n");
+        return -1;
+    }
+    pthread_attr_destroy(&attr);
+    int job_id = job->id;
+    pthread_mutex_unlock(&ctx->job_lock);
+    return job_id;
+}
+
+// Ask a job to stop at its next epoch boundary
+int job_cancel(OneCoreCtx *ctx, int job_id) {
+    pthread_mutex_lock(&ctx->job_lock);
+    Job *job = job_find(ctx, job_id);
+    if (!job) {
+        pthread_mutex_unlock(&ctx->job_lock);
+        printf("No job %d.\n", job_id);
+        return -1;
+    }
+    if (job_finished(job)) {
+        printf("Job %d already %s.\n", job_id, job_state_names[atomic_load(&job->state)]);
+    } else {
+        atomic_store(&job->control.cancel, 1);
+        printf("Cancelling job %d at the next epoch.\n", job_id);
+    }
+    pthread_mutex_unlock(&ctx->job_lock);
+    return 0;
+}
+
+// Wait for a job to finish. Returns -1 if it failed (a cancelled job did what was asked).
+int job_wait(OneCoreCtx *ctx, int job_id) {
+    pthread_mutex_lock(&ctx->job_lock);
+    Job *job = job_find(ctx, job_id);
+    if (!job) {
+        pthread_mutex_unlock(&ctx->job_lock);
+        printf("No job %d.\n", job_id);
+        return -1;
+    }
+    while (!job_finished(job)) {
+        pthread_cond_wait(&ctx->job_done, &ctx->job_lock);
+    }
+    JobState state = atomic_load(&job->state);
+    job->waited = 1;
+    printf("Job %d %s (%.2f s)\n", job_id, job_state_names[state], job->seconds);
+    pthread_mutex_unlock(&ctx->job_lock);
+    return state == JOB_FAILED ? -1 : 0;
+}
+
+// Wait for every job. Returns the number that failed and were not waited for.
+int job_wait_all(OneCoreCtx *ctx) {
+    pthread_mutex_lock(&ctx->job_lock);
+    while (ctx->jobs_active > 0) {
+        pthread_cond_wait(&ctx->job_done, &ctx->job_lock);
+    }
+    int failures = 0;
+    for (int i = 0; i < MAX_JOBS; i++) {
+        Job *job = &ctx->jobs[i];
+        if (job->id && !job->waited && atomic_load(&job->state) == JOB_FAILED) failures++;
+        job->waited = 1;
+    }
+    pthread_mutex_unlock(&ctx->job_lock);
+    return failures;
+}
+
+// Cancel every job and wait for them (before exit or destroying the context)
+void job_shutdown(OneCoreCtx *ctx) {
+    pthread_mutex_lock(&ctx->job_lock);
+    if (ctx->jobs_active > 0) {
+        printf("Cancelling %d job(s)...\n", ctx->jobs_active);
+    }
+    for (int i = 0; i < MAX_JOBS; i++) {
+        if (ctx->jobs[i].id && !job_finished(&ctx->jobs[i])) {
+            atomic_store(&ctx->jobs[i].control.cancel, 1);
+        }
+    }
+    pthread_mutex_unlock(&ctx->job_lock);
+    job_wait_all(ctx);
+}
+
+int job_active(OneCoreCtx *ctx) {
+    pthread_mutex_lock(&ctx->job_lock);
+    int active = ctx->jobs_active;
+    pthread_mutex_unlock(&ctx->job_lock);
+    return active;
+}
+
+// ID of an unfinished job that trains core_id, or 0
+int job_core_busy(OneCoreCtx *ctx, int core_id) {
+    int job_id = 0;
+    pthread_mutex_lock(&ctx->job_lock);
+    for (int i = 0; i < MAX_JOBS && !job_id; i++) {
+        Job *job = &ctx->jobs[i];
+        if (job->id && !job_finished(job) && job_has_core(job, core_id)) job_id = job->id;
+    }
+    pthread_mutex_unlock(&ctx->job_lock);
+    return job_id;
+}
+
+// 'jobs' command
+void job_list(OneCoreCtx *ctx) {
+    pthread_mutex_lock(&ctx->job_lock);
+    int order[MAX_JOBS], count = 0;
+    for (int i = 0; i < MAX_JOBS; i++) {
+        if (ctx->jobs[i].id) order[count++] = i;
+    }
+    if (count == 0) {
+        pthread_mutex_unlock(&ctx->job_lock);
+        printf("No jobs.\n");
+        return;
+    }
+    // Oldest first
+    for (int i = 1; i < count; i++) {
+        for (int j = i; j > 0 && ctx->jobs[order[j]].id < ctx->jobs[order[j - 1]].id; j--) {
+            int t = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = t;
+        }
+    }
+
+    printf("  %-4s %-10s %-7s %-20s %15s %9s\n", "ID", "State", "Kind", "Cores", "Epochs", "Seconds");
+    for (int i = 0; i < count; i++) {
+        Job *job = &ctx->jobs[order[i]];
+        char cores[32] = "all";
+        if (job->kind != JOB_RUN) {
+            size_t used = 0;
+            cores[0] = 0;
+            for (int c = 0; c < job->core_count && used < sizeof(cores) - 1; c++) {
+                int n = snprintf(cores + used, sizeof(cores) - used, c ? ",%d" : "%d", job->core_ids[c]);
+                used += n > 0 ? (size_t)n : 0;
+            }
+        }
+        char epochs[32];
+        snprintf(epochs, sizeof(epochs), "%ld/%ld", atomic_load(&job->control.epochs_done), job->total_epochs);
+        double seconds = job_finished(job) ? job->seconds : job_now() - job->started;
+        printf("  %-4d %-10s %-7s %-20.20s %15s %9.2f\n", job->id, job_state_names[atomic_load(&job->state)],
+               job_kind_names[job->kind], cores, epochs, seconds);
+    }
+    pthread_mutex_unlock(&ctx->job_lock);
+}
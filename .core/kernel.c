@@ -0,0 +1,278 @@
+/*
+
+    OneCoreAI - Specialized Epoch Kernels
+
+    The loss type, whether L2 regularization is on and whether the dataset
+    uses data sheet modifiers are fixed for a whole training call, so the
+    per-sample loop is generated once for every combination and the
+    variant is picked up front instead of switching on each sample. Loss
+    and gradient come from one fused block that computes the prediction
+    error once.
+
+    For MSE the loss and gradients are polynomials in x and y, and a data
+    sheet byte only scales, swaps or zeroes (dw, db). An epoch can
+    therefore be computed from sums of 1, x, y, x^2, xy and y^2 over the
+    samples with each sheet value. Those are gathered in one pass before
+    training, and every epoch after that is O(256) instead of O(N).
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "handle.h"
+
+// Fused loss + gradient factor for each loss type: *loss is the sample
+// loss, *grad the derivative of the loss with respect to the prediction
+
+static inline void kernel_mse(float error, float delta, float *loss, float *grad) {
+    (void)delta;
+    *loss = error * error;
+    *grad = 2.0f * error;
+}
+
+static inline void kernel_mae(float error, float delta, float *loss, float *grad) {
+    (void)delta;
+    *loss = error < 0 ? -error : error;
+    *grad = error < 0 ? -1.0f : 1.0f;
+}
+
+static inline void kernel_huber(float error, float delta, float *loss, float *grad) {
+    float abs_error = error < 0 ? -error : error;
+    if (abs_error <= delta) {
+        *loss = 0.5f * error * error;
+        *grad = error;
+    } else {
+        *loss = delta * (abs_error - 0.5f * delta);
+        *grad = delta * (error < 0 ? -1.0f : 1.0f);
+    }
+}
+
+// Loss and gradient factor block: loss of one prediction error, and in
+// *grad the derivative of that loss with respect to the prediction
+float ai_block_loss_factor(float error, LossType loss_type, float delta, float *grad) {
+    float loss;
+    switch (loss_type) {
+        case LOSS_MAE:
+            kernel_mae(error, delta, &loss, grad);
+            break;
+        case LOSS_HUBER:
+            kernel_huber(error, delta, &loss, grad);
+            break;
+        default:
+            kernel_mse(error, delta, &loss, grad);
+    }
+    return loss;
+}
+
+// Data sheet bits folded into one rule per byte: scale both gradients,
+// then optionally swap or zero them
+typedef struct {
+    float scale_w;
+    float scale_b;
+    unsigned char swap;
+    unsigned char zero;
+} SheetRule;
+
+static SheetRule sheet_rules[256];
+
+static void kernel_init_sheet_rules() {
+    for (int hex = 0; hex < 256; hex++) {
+        SheetRule *rule = &sheet_rules[hex];
+        rule->scale_w = 1.0f;
+        rule->scale_b = 1.0f;
+        if (hex & 0x01) rule->scale_w *= 2.0f;   // Bit 0: Amplify weight gradient
+        if (hex & 0x02) rule->scale_b *= 2.0f;   // Bit 1: Amplify bias gradient
+        if (hex & 0x04) rule->scale_w = -rule->scale_w;  // Bit 2: Invert weight gradient
+        if (hex & 0x08) rule->scale_b = -rule->scale_b;  // Bit 3: Invert bias gradient
+        if (hex & 0x10) {                        // Bit 4: Scale gradients up
+            rule->scale_w *= 1.5f;
+            rule->scale_b *= 1.5f;
+        }
+        if (hex & 0x20) {                        // Bit 5: Scale gradients down
+            rule->scale_w *= 0.5f;
+            rule->scale_b *= 0.5f;
+        }
+        rule->swap = (hex & 0x40) != 0;          // Bit 6: Swap gradients
+        rule->zero = (hex & 0x80) != 0;          // Bit 7: Zero gradients
+    }
+}
+
+// One epoch over the dataset for a fixed (loss, regularization, sheet)
+// combination. REG and SHEET are constants, so their branches fold away.
+#define EPOCH_KERNEL(name, LOSS, REG, SHEET)                                        \
+static void name(const AICore *core, const Dataset *dataset, EpochSums *sums) {     \
+    const float w = core->weight, b = core->bias, delta = core->huber_delta;        \
+    const float lambda = core->regularization_lambda;                               \
+    const float reg_loss = lambda * (w * w + b * b) / 2.0f;                         \
+    const float reg_dw = lambda * w, reg_db = lambda * b;                           \
+    float total_loss = 0.0f, sum_dw = 0.0f, sum_db = 0.0f;                          \
+    (void)reg_loss; (void)reg_dw; (void)reg_db;                                     \
+                                                                                    \
+    for (size_t start = 0; start < dataset->size; start += DATASET_CHUNK) {         \
+        DatasetChunk chunk;                                                         \
+        size_t count = dataset_chunk(dataset, start, DATASET_CHUNK, &chunk);        \
+        for (size_t i = 0; i < count; i++) {                                        \
+            float x = chunk.x[i];                                                   \
+            float loss, grad;                                                       \
+            LOSS(w * x + b - chunk.y[i], delta, &loss, &grad);                      \
+            float dw = grad * x, db = grad;                                         \
+            if (REG) {                                                              \
+                loss += reg_loss;                                                   \
+                dw += reg_dw;                                                       \
+                db += reg_db;                                                       \
+            }                                                                       \
+            total_loss += loss;                                                     \
+            if (SHEET) {                                                            \
+                const SheetRule *rule = &sheet_rules[chunk.data_sheet[i]];          \
+                float sw = dw * rule->scale_w, sb = db * rule->scale_b;             \
+                dw = rule->swap ? sb : sw;                                          \
+                db = rule->swap ? sw : sb;                                          \
+                if (rule->zero) dw = db = 0.0f;                                     \
+            }                                                                       \
+            sum_dw += dw;                                                           \
+            sum_db += db;                                                           \
+        }                                                                           \
+    }                                                                               \
+                                                                                    \
+    sums->loss = total_loss;                                                        \
+    sums->dw = sum_dw;                                                              \
+    sums->db = sum_db;                                                              \
+    sums->count = dataset->size;                                                    \
+}
+
+EPOCH_KERNEL(epoch_mse,             kernel_mse,   0, 0)
+EPOCH_KERNEL(epoch_mse_sheet,       kernel_mse,   0, 1)
+EPOCH_KERNEL(epoch_mse_reg,         kernel_mse,   1, 0)
+EPOCH_KERNEL(epoch_mse_reg_sheet,   kernel_mse,   1, 1)
+EPOCH_KERNEL(epoch_mae,             kernel_mae,   0, 0)
+EPOCH_KERNEL(epoch_mae_sheet,       kernel_mae,   0, 1)
+EPOCH_KERNEL(epoch_mae_reg,         kernel_mae,   1, 0)
+EPOCH_KERNEL(epoch_mae_reg_sheet,   kernel_mae,   1, 1)
+EPOCH_KERNEL(epoch_huber,           kernel_huber, 0, 0)
+EPOCH_KERNEL(epoch_huber_sheet,     kernel_huber, 0, 1)
+EPOCH_KERNEL(epoch_huber_reg,       kernel_huber, 1, 0)
+EPOCH_KERNEL(epoch_huber_reg_sheet, kernel_huber, 1, 1)
+
+// Indexed by [loss type][regularization][data sheet]
+static const EpochKernel epoch_kernels[3][2][2] = {
+    [LOSS_MSE]   = { { epoch_mse,   epoch_mse_sheet   }, { epoch_mse_reg,   epoch_mse_reg_sheet   } },
+    [LOSS_MAE]   = { { epoch_mae,   epoch_mae_sheet   }, { epoch_mae_reg,   epoch_mae_reg_sheet   } },
+    [LOSS_HUBER] = { { epoch_huber, epoch_huber_sheet }, { epoch_huber_reg, epoch_huber_reg_sheet } },
+};
+
+// Does any sample carry data sheet modifiers?
+static int dataset_uses_sheet(const Dataset *data) {
+    if (dataset_is_implicit(data)) {
+        const DatasetColumn *sheet = &data->sheet_column;
+        switch (sheet->kind) {
+            case COLUMN_CONSTANT:
+                return generator_sheet_byte(sheet->value) != 0;
+            case COLUMN_RANDOM:
+                for (int i = 0; i < 8; i++) {
+                    if (sheet->threshold[i]) return 1;
+                }
+                return 0;
+            default:
+                return 1;
+        }
+    }
+    static const unsigned char zeros[4096];
+    for (size_t start = 0; start < data->size; start += sizeof(zeros)) {
+        size_t count = data->size - start < sizeof(zeros) ? data->size - start : sizeof(zeros);
+        if (memcmp(data->data_sheet + start, zeros, count) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void kernel_rules_ready() {
+    static pthread_once_t rules_once = PTHREAD_ONCE_INIT;
+    pthread_once(&rules_once, kernel_init_sheet_rules);
+}
+
+// Pick the epoch loop for this core's configuration and this dataset
+EpochKernel ai_block_select_kernel(const AICore *core, const Dataset *data) {
+    kernel_rules_ready();
+
+    int loss = core->loss_type >= LOSS_MSE && core->loss_type <= LOSS_HUBER ? core->loss_type : LOSS_MSE;
+    int reg = core->regularization_lambda > 0.0f;
+    return epoch_kernels[loss][reg][dataset_uses_sheet(data)];
+}
+
+// ONECORE_NO_GROUPED=1 keeps every epoch on the per-sample loops (to check
+// the grouped path against them, or to time them)
+static int grouped_disabled;
+
+static void kernel_init_grouped() {
+    grouped_disabled = getenv("ONECORE_NO_GROUPED") != NULL;
+}
+
+// Can this core's epochs run from per-sheet sufficient statistics?
+int ai_block_uses_sheet_stats(const AICore *core) {
+    static pthread_once_t grouped_once = PTHREAD_ONCE_INIT;
+    pthread_once(&grouped_once, kernel_init_grouped);
+    return !grouped_disabled && core->type == CORE_LINEAR && core->loss_type == LOSS_MSE;
+}
+
+// One pass over the dataset: per sheet value sums of 1, x, y, x^2, xy, y^2
+void ai_block_sheet_stats(const Dataset *data, SheetStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    for (size_t start = 0; start < data->size; start += DATASET_CHUNK) {
+        DatasetChunk chunk;
+        size_t count = dataset_chunk(data, start, DATASET_CHUNK, &chunk);
+        for (size_t i = 0; i < count; i++) {
+            int hex = chunk.data_sheet[i];
+            double x = chunk.x[i], y = chunk.y[i];
+            stats->n[hex] += 1.0;
+            stats->x[hex] += x;
+            stats->y[hex] += y;
+            stats->xx[hex] += x * x;
+            stats->xy[hex] += x * y;
+            stats->yy[hex] += y * y;
+        }
+    }
+    for (int hex = 0; hex < 256; hex++) {
+        if (stats->n[hex] > 0.0) stats->used[stats->used_count++] = (unsigned char)hex;
+    }
+    stats->count = data->size;
+}
+
+// MSE epoch from sufficient statistics: per group, with e = w * x + b - y,
+//   sum e^2 = w^2 Sxx + 2wb Sx + b^2 n - 2w Sxy - 2b Sy + Syy
+//   sum e x = w Sxx + b Sx - Sxy,   sum e = w Sx + b n - Sy
+// then the group's sheet rule applied to its (dw, db), as the sample loop does
+void ai_block_epoch_grouped(const AICore *core, const SheetStats *stats, EpochSums *sums) {
+    kernel_rules_ready();
+    const double w = core->weight, b = core->bias;
+    const double lambda = core->regularization_lambda;
+    const double reg_loss = lambda * (w * w + b * b) / 2.0;
+    const double reg_dw = lambda * w, reg_db = lambda * b;
+    double total_loss = 0.0, sum_dw = 0.0, sum_db = 0.0;
+
+    for (int g = 0; g < stats->used_count; g++) {
+        int hex = stats->used[g];
+        double n = stats->n[hex], sx = stats->x[hex], sy = stats->y[hex];
+        double sxx = stats->xx[hex], sxy = stats->xy[hex], syy = stats->yy[hex];
+
+        double loss = w * w * sxx + 2.0 * w * b * sx + b * b * n - 2.0 * w * sxy - 2.0 * b * sy + syy;
+        double dw = 2.0 * (w * sxx + b * sx - sxy) + n * reg_dw;
+        double db = 2.0 * (w * sx + b * n - sy) + n * reg_db;
+        total_loss += loss + n * reg_loss;
+
+        const SheetRule *rule = &sheet_rules[hex];
+        double sw = dw * rule->scale_w, sb = db * rule->scale_b;
+        dw = rule->swap ? sb : sw;
+        db = rule->swap ? sw : sb;
+        if (rule->zero) dw = db = 0.0;
+        sum_dw += dw;
+        sum_db += db;
+    }
+
+    sums->loss = (float)total_loss;
+    sums->dw = (float)sum_dw;
+    sums->db = (float)sum_db;
+    sums->count = stats->count;
+}
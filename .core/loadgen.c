@@ -0,0 +1,282 @@
+/*
+
+    OneCoreAI - Load Generator
+
+    Drives the prediction server with pipelined requests from several
+    connections and reports throughput and latency percentiles.
+
+    Usage: onecoreai_loadgen [-s socket | -p port] [-c connections] [-d depth]
+                             [-t seconds] [-o predict|batch|fetch|learn]
+                             [-b batch_size] [-i core_id]
+
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "protocol.h"
+
+#define LOADGEN_MAX_DEPTH 256
+
+typedef struct {
+    pthread_t thread;
+    int fd;
+    uint64_t *latencies;     // Nanoseconds, one per completed request
+    size_t count, capacity;
+    unsigned long errors;
+} LoadgenConn;
+
+static struct {
+    const char *socket_path;
+    int tcp_port;
+    int connections;
+    int depth;
+    double seconds;
+    ServerOp op;
+    int batch;
+    int core_id;
+} config = { "/tmp/onecoreai.sock", 0, 4, 16, 5.0, SERVER_OP_PREDICT, 1, 1 };
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int loadgen_connect() {
+    int fd;
+    if (config.tcp_port > 0) {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(config.tcp_port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", config.socket_path);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+static int write_all(int fd, const void *buf, size_t len) {
+    const unsigned char *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// Build one request with a given tag into buf, returns its size
+static size_t loadgen_request(unsigned char *buf, uint32_t tag) {
+    ServerRequest req = { (uint8_t)config.op, (uint8_t)config.core_id, 0, tag };
+    float values[SERVER_MAX_VALUES];
+
+    switch (config.op) {
+        case SERVER_OP_PREDICT:
+            req.count = 1;
+            values[0] = (float)(tag % 1000) / 100.0f;
+            break;
+        case SERVER_OP_BATCH_PREDICT:
+            req.count = config.batch;
+            for (int i = 0; i < config.batch; i++) values[i] = (float)i / 100.0f;
+            break;
+        case SERVER_OP_LEARN:
+            req.count = 2;
+            values[0] = (float)(tag % 1000) / 100.0f;
+            values[1] = 2.0f * values[0] + 1.0f;
+            break;
+        default:
+            break;
+    }
+    memcpy(buf, &req, sizeof(req));
+    memcpy(buf + sizeof(req), values, req.count * sizeof(float));
+    return sizeof(req) + req.count * sizeof(float);
+}
+
+static void record(LoadgenConn *conn, uint64_t latency) {
+    if (conn->count == conn->capacity) {
+        conn->capacity = conn->capacity ? conn->capacity * 2 : 65536;
+        conn->latencies = realloc(conn->latencies, conn->capacity * sizeof(uint64_t));
+    }
+    conn->latencies[conn->count++] = latency;
+}
+
+static void *loadgen_run(void *arg) {
+    LoadgenConn *conn = arg;
+    uint64_t sent_at[LOADGEN_MAX_DEPTH];
+    unsigned char out[LOADGEN_MAX_DEPTH * (sizeof(ServerRequest) + SERVER_MAX_VALUES * sizeof(float))];
+    unsigned char in[64 * 1024];
+    size_t in_len = 0;
+    uint32_t next_tag = 0;
+
+    uint64_t deadline = now_ns() + (uint64_t)(config.seconds * 1e9);
+
+    // Fill the pipeline
+    size_t out_len = 0;
+    uint64_t start = now_ns();
+    for (int i = 0; i < config.depth; i++) {
+        sent_at[next_tag % config.depth] = start;
+        out_len += loadgen_request(out + out_len, next_tag++);
+    }
+    if (write_all(conn->fd, out, out_len) != 0) return NULL;
+
+    int outstanding = config.depth;
+    while (outstanding > 0) {
+        ssize_t n = read(conn->fd, in + in_len, sizeof(in) - in_len);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            break;
+        }
+        in_len += n;
+
+        uint64_t t = now_ns();
+        int refill = t < deadline;
+        size_t pos = 0;
+        out_len = 0;
+        while (in_len - pos >= sizeof(ServerResponse)) {
+            ServerResponse resp;
+            memcpy(&resp, in + pos, sizeof(resp));
+            size_t size = sizeof(resp) + resp.count * sizeof(float);
+            if (in_len - pos < size) break;
+            pos += size;
+
+            record(conn, t - sent_at[resp.tag % config.depth]);
+            if (resp.status != SERVER_OK) conn->errors++;
+            outstanding--;
+
+            if (refill) {
+                sent_at[next_tag % config.depth] = t;
+                out_len += loadgen_request(out + out_len, next_tag++);
+                outstanding++;
+            }
+        }
+        memmove(in, in + pos, in_len - pos);
+        in_len -= pos;
+
+        if (out_len > 0 && write_all(conn->fd, out, out_len) != 0) break;
+    }
+    return NULL;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-s socket | -p port] [-c connections] [-d depth] [-t seconds]\n"
+                    "          [-o predict|batch|fetch|learn] [-b batch_size] [-i core_id]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "s:p:c:d:t:o:b:i:h")) != -1) {
+        switch (opt) {
+            case 's': config.socket_path = optarg; break;
+            case 'p': config.tcp_port = atoi(optarg); break;
+            case 'c': config.connections = atoi(optarg); break;
+            case 'd': config.depth = atoi(optarg); break;
+            case 't': config.seconds = atof(optarg); break;
+            case 'b': config.batch = atoi(optarg); break;
+            case 'i': config.core_id = atoi(optarg); break;
+            case 'o':
+                if (strcmp(optarg, "predict") == 0) config.op = SERVER_OP_PREDICT;
+                else if (strcmp(optarg, "batch") == 0) config.op = SERVER_OP_BATCH_PREDICT;
+                else if (strcmp(optarg, "fetch") == 0) config.op = SERVER_OP_FETCH;
+                else if (strcmp(optarg, "learn") == 0) config.op = SERVER_OP_LEARN;
+                else { usage(argv[0]); return 2; }
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (config.connections < 1) config.connections = 1;
+    if (config.depth < 1) config.depth = 1;
+    if (config.depth > LOADGEN_MAX_DEPTH) config.depth = LOADGEN_MAX_DEPTH;
+    if (config.batch < 1) config.batch = 1;
+    if (config.batch > SERVER_MAX_VALUES) config.batch = SERVER_MAX_VALUES;
+
+    LoadgenConn *conns = calloc(config.connections, sizeof(LoadgenConn));
+    for (int i = 0; i < config.connections; i++) {
+        conns[i].fd = loadgen_connect();
+        if (conns[i].fd < 0) {
+            perror("connect");
+            return 1;
+        }
+    }
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < config.connections; i++) {
+        pthread_create(&conns[i].thread, NULL, loadgen_run, &conns[i]);
+    }
+    for (int i = 0; i < config.connections; i++) {
+        pthread_join(conns[i].thread, NULL);
+        close(conns[i].fd);
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+
+    // Merge latencies from all connections
+    size_t total = 0;
+    unsigned long errors = 0;
+    for (int i = 0; i < config.connections; i++) {
+        total += conns[i].count;
+        errors += conns[i].errors;
+    }
+    if (total == 0) {
+        fprintf(stderr, "No responses received.\n");
+        return 1;
+    }
+    uint64_t *all = malloc(total * sizeof(uint64_t));
+    size_t k = 0;
+    for (int i = 0; i < config.connections; i++) {
+        memcpy(all + k, conns[i].latencies, conns[i].count * sizeof(uint64_t));
+        k += conns[i].count;
+        free(conns[i].latencies);
+    }
+    qsort(all, total, sizeof(uint64_t), compare_u64);
+
+    int per_request = config.op == SERVER_OP_BATCH_PREDICT ? config.batch : 1;
+    printf("Requests:    %zu in %.2fs (%d connections, depth %d)\n",
+           total, elapsed, config.connections, config.depth);
+    printf("Throughput:  %.0f req/s", total / elapsed);
+    if (per_request > 1) printf(", %.0f predictions/s", total * (double)per_request / elapsed);
+    printf("\nErrors:      %lu\n", errors);
+    printf("Latency:     p50 %.1fus  p99 %.1fus  p99.9 %.1fus  max %.1fus\n",
+           all[total / 2] / 1e3, all[(size_t)(total * 0.99)] / 1e3,
+           all[(size_t)(total * 0.999)] / 1e3, all[total - 1] / 1e3);
+
+    free(all);
+    free(conns);
+    return errors > 0 ? 1 : 0;
+}
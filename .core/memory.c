@@ -0,0 +1,159 @@
+/*
+
+    OneCoreAI - Memory Accounting
+
+    Bytes owned by each core (parameters, loss history, optimizer state,
+    the published snapshot entry and any dataset it is training on), live
+    dataset storage, run arenas and the process RSS from /proc/self/statm.
+    Everything is tracked in-process, so `size` and `metrics` answer
+    immediately without running external tools.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "handle.h"
+#include "context.h"
+#include "onecore_shm.h"
+
+// Dataset storage is counted for the whole process; per-core figures live in the context
+static _Atomic size_t dataset_live;
+static _Atomic size_t dataset_peak;
+static _Atomic unsigned long dataset_count;
+
+// Called by dataset.c whenever sample storage is allocated or freed
+void memory_dataset_alloc(size_t bytes) {
+    size_t live = atomic_fetch_add(&dataset_live, bytes) + bytes;
+    size_t peak = atomic_load(&dataset_peak);
+    while (live > peak && !atomic_compare_exchange_weak(&dataset_peak, &peak, live)) {
+    }
+    atomic_fetch_add(&dataset_count, 1);
+}
+
+void memory_dataset_free(size_t bytes) {
+    atomic_fetch_sub(&dataset_live, bytes);
+    atomic_fetch_sub(&dataset_count, 1);
+}
+
+// Record the dataset a core is training on (0 when training ends)
+void memory_core_dataset(OneCoreCtx *ctx, int core_id, size_t bytes) {
+    if (core_id < 1 || core_id > MAX_CORES) {
+        return;
+    }
+    atomic_store(&ctx->core_dataset[core_id - 1], bytes);
+    if (bytes > 0) {
+        atomic_store(&ctx->core_dataset_last[core_id - 1], bytes);
+    }
+}
+
+// Core core_id of `count` was deleted and the ones after it moved down one ID;
+// move their dataset counters with them (caller holds every core lock)
+void memory_core_deleted(OneCoreCtx *ctx, int core_id, int count) {
+    if (core_id < 1 || count > MAX_CORES) {
+        return;
+    }
+    for (int i = core_id - 1; i < count - 1; i++) {
+        atomic_store(&ctx->core_dataset[i], atomic_load(&ctx->core_dataset[i + 1]));
+        atomic_store(&ctx->core_dataset_last[i], atomic_load(&ctx->core_dataset_last[i + 1]));
+    }
+    if (count >= core_id) {
+        atomic_store(&ctx->core_dataset[count - 1], 0);
+        atomic_store(&ctx->core_dataset_last[count - 1], 0);
+    }
+}
+
+// Every core was cleared
+void memory_cores_cleared(OneCoreCtx *ctx) {
+    for (int i = 0; i < MAX_CORES; i++) {
+        atomic_store(&ctx->core_dataset[i], 0);
+        atomic_store(&ctx->core_dataset_last[i], 0);
+    }
+}
+
+// Bytes owned by a core. Returns -1 if the ID is invalid.
+int memory_core(OneCoreCtx *ctx, int core_id, CoreMemory *out) {
+    AICore *core = core_get(ctx, core_id);
+    if (!core) {
+        return -1;
+    }
+    out->history = sizeof(core->loss_history) + sizeof(core->loss_count);
+    out->history_used = core->loss_count * sizeof(core->loss_history[0]);
+    // Plain SGD keeps no state between steps; the streaming learner keeps its window sums
+    out->optimizer = sizeof(core->stream);
+    out->parameters = sizeof(AICore) - out->history - out->optimizer + mlp_bytes(core->mlp);
+    out->snapshot = sizeof(OneCoreShmEntry);
+    out->dataset = atomic_load(&ctx->core_dataset[core_id - 1]);
+    out->dataset_last = atomic_load(&ctx->core_dataset_last[core_id - 1]);
+    return 0;
+}
+
+// Process memory from /proc/self/statm, in bytes
+int memory_process(size_t *virtual_bytes, size_t *resident, size_t *shared) {
+    FILE *file = fopen("/proc/self/statm", "r");
+    if (!file) {
+        return -1;
+    }
+    unsigned long size = 0, rss = 0, shr = 0;
+    int fields = fscanf(file, "%lu %lu %lu", &size, &rss, &shr);
+    fclose(file);
+    if (fields != 3) {
+        return -1;
+    }
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    *virtual_bytes = size * page;
+    *resident = rss * page;
+    *shared = shr * page;
+    return 0;
+}
+
+static size_t core_total(const CoreMemory *mem) {
+    return mem->parameters + mem->history + mem->optimizer + mem->snapshot + mem->dataset;
+}
+
+static void memory_print_process() {
+    size_t virtual_bytes, resident, shared;
+    if (memory_process(&virtual_bytes, &resident, &shared) == 0) {
+        printf("Process: RSS %.2f MB (shared %.2f MB), virtual %.2f MB\n",
+               resident / 1e6, shared / 1e6, virtual_bytes / 1e6);
+    } else {
+        printf("Process: /proc/self/statm unavailable\n");
+    }
+}
+
+// 'size' command: what one core owns, plus the process totals
+int memory_report_core(OneCoreCtx *ctx, int core_id) {
+    CoreMemory mem;
+    if (memory_core(ctx, core_id, &mem) != 0) {
+        printf("Invalid core ID: %d\n", core_id);
+        return -1;
+    }
+    printf("Core %d memory: %zu bytes\n", core_id, core_total(&mem));
+    printf("  Parameters:   %zu\n", mem.parameters);
+    printf("  Loss history: %zu (%zu in use)\n", mem.history, mem.history_used);
+    printf("  Optimizer:    %zu\n", mem.optimizer);
+    printf("  Snapshot:     %zu\n", mem.snapshot);
+    printf("  Dataset:      %zu (last run: %zu)\n", mem.dataset, mem.dataset_last);
+    memory_print_process();
+    return 0;
+}
+
+// 'metrics' command: every core, datasets, arenas and the process
+void memory_report(OneCoreCtx *ctx) {
+    size_t cores_total = 0;
+    printf("=== Memory ===\n");
+    printf("  %-4s %-16s %10s %10s %12s %12s\n", "ID", "Name", "Core", "History", "Dataset", "Last run");
+    for (int i = 1; i <= ctx->active_cores; i++) {
+        CoreMemory mem;
+        if (memory_core(ctx, i, &mem) != 0) continue;
+        cores_total += core_total(&mem);
+        printf("  %-4d %-16.16s %10zu %10zu %12zu %12zu\n", i, ctx->cores[i - 1].name,
+               core_total(&mem), mem.history_used, mem.dataset, mem.dataset_last);
+    }
+    printf("Cores: %d, %zu bytes\n", ctx->active_cores, cores_total);
+    printf("Datasets: %lu live, %.2f MB (peak %.2f MB)\n", atomic_load(&dataset_count),
+           atomic_load(&dataset_live) / 1e6, atomic_load(&dataset_peak) / 1e6);
+    arena_report();
+    memory_print_process();
+}
@@ -0,0 +1,575 @@
+/*
+
+    OneCoreAI - Multi-Layer Perceptron Cores
+
+    A core can be switched from the scalar linear model to a small MLP
+    (1 input, up to MLP_MAX_HIDDEN hidden layers with ReLU or tanh, 1
+    linear output) trained in mini-batches. Forward and backward passes
+    are three matrix products per layer, all done by one cache-blocked
+    GEMM: a 4x16 register tile with AVX2/FMA when the CPU has it, rows of
+    A kept in L1 and a KC x NC panel of B in L2. The transposed products
+    of the backward pass transpose their small operand into a scratch
+    buffer first, so the same kernel runs every product. The loss types,
+    L2 regularization and gradient clipping are the linear core's.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "handle.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MLP_HAVE_X86 1
+#endif
+
+#define MLP_MAX_HIDDEN 4
+#define MLP_MAX_WIDTH 512
+#define MLP_MAX_BATCH DATASET_CHUNK
+#define MLP_DEFAULT_BATCH 32
+
+// GEMM blocking: KC x NC panel of B (64 KB) stays in L2 while 4-row strips of A stream
+#define GEMM_KC 128
+#define GEMM_NC 128
+#define GEMM_MR 4
+#define GEMM_NR 16
+
+struct MlpModel {
+    int layers;                         // Weight layers (hidden + 1)
+    int width[MLP_MAX_HIDDEN + 2];      // width[0] = 1 input, width[layers] = 1 output
+    MlpActivation activation;
+    int batch;
+    float *w[MLP_MAX_HIDDEN + 1];       // width[l] x width[l + 1], row-major
+    float *b[MLP_MAX_HIDDEN + 1];
+    float *dw[MLP_MAX_HIDDEN + 1];
+    float *db[MLP_MAX_HIDDEN + 1];
+    float *act[MLP_MAX_HIDDEN + 2];     // batch x width[l]; act[0] is the input
+    float *grad[MLP_MAX_HIDDEN + 2];    // Loss gradient w.r.t. layer l's pre-activation
+    float *scratch;                     // Transposed operands
+    size_t parameters;                  // Number of weights and biases
+    size_t bytes;
+    float *block;                       // Everything above, one allocation
+};
+
+// Matrix multiply
+
+// C (m x n) = A (m x k) * B (k x n), or C += A * B when accumulate is set.
+// Row-major with leading dimensions lda, ldb, ldc.
+static void gemm_scalar(int m, int n, int k, const float *a, int lda, const float *b, int ldb,
+                        float *c, int ldc, int accumulate) {
+    for (int i = 0; i < m; i++) {
+        float *crow = c + (size_t)i * ldc;
+        if (!accumulate) memset(crow, 0, n * sizeof(float));
+        for (int p = 0; p < k; p++) {
+            float av = a[(size_t)i * lda + p];
+            const float *brow = b + (size_t)p * ldb;
+            for (int j = 0; j < n; j++) {
+                crow[j] += av * brow[j];
+            }
+        }
+    }
+}
+
+#ifdef MLP_HAVE_X86
+// 4 x 16 tile of C += A (4 x kc) * B (kc x 16), held in 8 accumulators
+__attribute__((target("avx2,fma")))
+static inline void gemm_tile_avx2(int kc, const float *a, int lda, const float *b, int ldb,
+                                  float *c, int ldc) {
+    __m256 c00 = _mm256_loadu_ps(c), c01 = _mm256_loadu_ps(c + 8);
+    __m256 c10 = _mm256_loadu_ps(c + ldc), c11 = _mm256_loadu_ps(c + ldc + 8);
+    __m256 c20 = _mm256_loadu_ps(c + 2 * ldc), c21 = _mm256_loadu_ps(c + 2 * ldc + 8);
+    __m256 c30 = _mm256_loadu_ps(c + 3 * ldc), c31 = _mm256_loadu_ps(c + 3 * ldc + 8);
+    for (int p = 0; p < kc; p++) {
+        __m256 b0 = _mm256_loadu_ps(b + (size_t)p * ldb);
+        __m256 b1 = _mm256_loadu_ps(b + (size_t)p * ldb + 8);
+        __m256 a0 = _mm256_broadcast_ss(a + p);
+        __m256 a1 = _mm256_broadcast_ss(a + lda + p);
+        __m256 a2 = _mm256_broadcast_ss(a + 2 * lda + p);
+        __m256 a3 = _mm256_broadcast_ss(a + 3 * lda + p);
+        c00 = _mm256_fmadd_ps(a0, b0, c00);
+        c01 = _mm256_fmadd_ps(a0, b1, c01);
+        c10 = _mm256_fmadd_ps(a1, b0, c10);
+        c11 = _mm256_fmadd_ps(a1, b1, c11);
+        c20 = _mm256_fmadd_ps(a2, b0, c20);
+        c21 = _mm256_fmadd_ps(a2, b1, c21);
+        c30 = _mm256_fmadd_ps(a3, b0, c30);
+        c31 = _mm256_fmadd_ps(a3, b1, c31);
+    }
+    _mm256_storeu_ps(c, c00);
+    _mm256_storeu_ps(c + 8, c01);
+    _mm256_storeu_ps(c + ldc, c10);
+    _mm256_storeu_ps(c + ldc + 8, c11);
+    _mm256_storeu_ps(c + 2 * ldc, c20);
+    _mm256_storeu_ps(c + 2 * ldc + 8, c21);
+    _mm256_storeu_ps(c + 3 * ldc, c30);
+    _mm256_storeu_ps(c + 3 * ldc + 8, c31);
+}
+
+// Edge rows/columns of a block: one row of C at a time, 8 columns per FMA
+__attribute__((target("avx2,fma")))
+static void gemm_edge_avx2(int m, int n, int kc, const float *a, int lda, const float *b, int ldb,
+                           float *c, int ldc) {
+    for (int i = 0; i < m; i++) {
+        float *crow = c + (size_t)i * ldc;
+        int j = 0;
+        for (; j + 8 <= n; j += 8) {
+            __m256 acc = _mm256_loadu_ps(crow + j);
+            for (int p = 0; p < kc; p++) {
+                acc = _mm256_fmadd_ps(_mm256_broadcast_ss(a + (size_t)i * lda + p),
+                                      _mm256_loadu_ps(b + (size_t)p * ldb + j), acc);
+            }
+            _mm256_storeu_ps(crow + j, acc);
+        }
+        for (; j < n; j++) {
+            float acc = crow[j];
+            for (int p = 0; p < kc; p++) {
+                acc += a[(size_t)i * lda + p] * b[(size_t)p * ldb + j];
+            }
+            crow[j] = acc;
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void gemm_avx2(int m, int n, int k, const float *a, int lda, const float *b, int ldb,
+                      float *c, int ldc, int accumulate) {
+    if (!accumulate) {
+        for (int i = 0; i < m; i++) memset(c + (size_t)i * ldc, 0, n * sizeof(float));
+    }
+    for (int pc = 0; pc < k; pc += GEMM_KC) {
+        int kc = k - pc < GEMM_KC ? k - pc : GEMM_KC;
+        for (int jc = 0; jc < n; jc += GEMM_NC) {
+            int nc = n - jc < GEMM_NC ? n - jc : GEMM_NC;
+            int n_full = nc / GEMM_NR * GEMM_NR;
+            const float *bp = b + (size_t)pc * ldb + jc;
+
+            int i = 0;
+            for (; i + GEMM_MR <= m; i += GEMM_MR) {
+                const float *ap = a + (size_t)i * lda + pc;
+                float *cp = c + (size_t)i * ldc + jc;
+                for (int j = 0; j < n_full; j += GEMM_NR) {
+                    gemm_tile_avx2(kc, ap, lda, bp + j, ldb, cp + j, ldc);
+                }
+                if (n_full < nc) {
+                    gemm_edge_avx2(GEMM_MR, nc - n_full, kc, ap, lda, bp + n_full, ldb, cp + n_full, ldc);
+                }
+            }
+            if (i < m) {
+                gemm_edge_avx2(m - i, nc, kc, a + (size_t)i * lda + pc, lda, bp, ldb,
+                               c + (size_t)i * ldc + jc, ldc);
+            }
+        }
+    }
+}
+#endif
+
+static int mlp_has_avx2() {
+#ifdef MLP_HAVE_X86
+    static int cached = -1;
+    if (cached < 0) cached = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return cached;
+#else
+    return 0;
+#endif
+}
+
+static void gemm(int m, int n, int k, const float *a, int lda, const float *b, int ldb,
+                 float *c, int ldc, int accumulate) {
+#ifdef MLP_HAVE_X86
+    if (mlp_has_avx2()) {
+        gemm_avx2(m, n, k, a, lda, b, ldb, c, ldc, accumulate);
+        return;
+    }
+#endif
+    gemm_scalar(m, n, k, a, lda, b, ldb, c, ldc, accumulate);
+}
+
+// out (cols x rows) = in (rows x cols) transposed
+static void transpose(int rows, int cols, const float *in, float *out) {
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            out[(size_t)j * rows + i] = in[(size_t)i * cols + j];
+        }
+    }
+}
+
+// Model
+
+static uint64_t mlp_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Carve `count` floats off the model block, keeping cache-line alignment
+static float *mlp_take(float **next, size_t count) {
+    float *p = *next;
+    *next += (count + 15) & ~(size_t)15;
+    return p;
+}
+
+// Build a model with the given hidden layer widths. Weights start uniform in
+// +-sqrt(6 / fan_in) (ReLU) or +-sqrt(6 / (fan_in + fan_out)) (tanh), biases at 0.
+MlpModel *mlp_create(const int *hidden, int hidden_count, MlpActivation activation, int batch, uint64_t seed) {
+    if (hidden_count < 1 || hidden_count > MLP_MAX_HIDDEN) {
+        return NULL;
+    }
+    MlpModel *model = calloc(1, sizeof(MlpModel));
+    if (!model) {
+        return NULL;
+    }
+    model->layers = hidden_count + 1;
+    model->activation = activation;
+    model->batch = batch >= 1 && batch <= MLP_MAX_BATCH ? batch : MLP_DEFAULT_BATCH;
+    model->width[0] = 1;
+    for (int l = 0; l < hidden_count; l++) {
+        if (hidden[l] < 1 || hidden[l] > MLP_MAX_WIDTH) {
+            free(model);
+            return NULL;
+        }
+        model->width[l + 1] = hidden[l];
+    }
+    model->width[model->layers] = 1;
+
+    // Lay out every array in one block, each starting on a cache line
+    size_t floats = 0, scratch = 0;
+    for (int l = 0; l < model->layers; l++) {
+        size_t weights = (size_t)model->width[l] * model->width[l + 1];
+        size_t activations = (size_t)model->batch * model->width[l];
+        floats += 2 * ((weights + 15) & ~(size_t)15) + 2 * ((model->width[l + 1] + 15) & ~(size_t)15);
+        model->parameters += weights + model->width[l + 1];
+        if (weights > scratch) scratch = weights;
+        if (activations > scratch) scratch = activations;
+    }
+    for (int l = 0; l <= model->layers; l++) {
+        floats += 2 * (((size_t)model->batch * model->width[l] + 15) & ~(size_t)15);
+    }
+    floats += (scratch + 15) & ~(size_t)15;
+
+    model->bytes = floats * sizeof(float);
+    model->block = aligned_alloc(64, model->bytes);
+    if (!model->block) {
+        free(model);
+        return NULL;
+    }
+    memset(model->block, 0, model->bytes);
+
+    float *next = model->block;
+    for (int l = 0; l < model->layers; l++) {
+        size_t weights = (size_t)model->width[l] * model->width[l + 1];
+        model->w[l] = mlp_take(&next, weights);
+        model->dw[l] = mlp_take(&next, weights);
+        model->b[l] = mlp_take(&next, model->width[l + 1]);
+        model->db[l] = mlp_take(&next, model->width[l + 1]);
+    }
+    for (int l = 0; l <= model->layers; l++) {
+        model->act[l] = mlp_take(&next, (size_t)model->batch * model->width[l]);
+        model->grad[l] = mlp_take(&next, (size_t)model->batch * model->width[l]);
+    }
+    model->scratch = mlp_take(&next, scratch);
+
+    uint64_t state = seed;
+    for (int l = 0; l < model->layers; l++) {
+        int fan_in = model->width[l], fan_out = model->width[l + 1];
+        float limit = activation == MLP_TANH && l + 1 < model->layers
+                          ? sqrtf(6.0f / (fan_in + fan_out)) : sqrtf(6.0f / fan_in);
+        for (size_t i = 0; i < (size_t)fan_in * fan_out; i++) {
+            float u = (float)(mlp_random(&state) >> 40) * (1.0f / 16777216.0f);
+            model->w[l][i] = (2.0f * u - 1.0f) * limit;
+        }
+    }
+    return model;
+}
+
+void mlp_free(MlpModel *model) {
+    if (model) {
+        free(model->block);
+        free(model);
+    }
+}
+
+size_t mlp_bytes(const MlpModel *model) {
+    return model ? sizeof(MlpModel) + model->bytes : 0;
+}
+
+// "1-16-16-1 tanh, batch 32, 321 parameters"
+void mlp_describe(const MlpModel *model, char *out, size_t size) {
+    int used = snprintf(out, size, "%d", model->width[0]);
+    for (int l = 1; l <= model->layers && used > 0 && (size_t)used < size; l++) {
+        used += snprintf(out + used, size - used, "-%d", model->width[l]);
+    }
+    if (used > 0 && (size_t)used < size) {
+        snprintf(out + used, size - used, " %s, batch %d, %zu parameters",
+                 model->activation == MLP_TANH ? "tanh" : "relu", model->batch, model->parameters);
+    }
+}
+
+// Forward pass over act[0] (count x 1); leaves the predictions in act[layers]
+static void mlp_forward_batch(MlpModel *model, int count) {
+    for (int l = 0; l < model->layers; l++) {
+        int in = model->width[l], out = model->width[l + 1];
+        float *z = model->act[l + 1];
+        gemm(count, out, in, model->act[l], in, model->w[l], out, z, out, 0);
+
+        const float *bias = model->b[l];
+        int hidden = l + 1 < model->layers;
+        for (int i = 0; i < count; i++) {
+            float *row = z + (size_t)i * out;
+            for (int j = 0; j < out; j++) {
+                float v = row[j] + bias[j];
+                if (hidden) v = model->activation == MLP_TANH ? tanhf(v) : (v > 0.0f ? v : 0.0f);
+                row[j] = v;
+            }
+        }
+    }
+}
+
+float mlp_predict(MlpModel *model, float x) {
+    model->act[0][0] = x;
+    mlp_forward_batch(model, 1);
+    return model->act[model->layers][0];
+}
+
+// One mini-batch: forward, loss, backward, then a clipped SGD step with L2.
+// Returns the summed loss over the batch (regularization included per sample,
+// as in the linear epoch).
+static float mlp_train_batch(MlpModel *model, const AICore *core, const float *x, const float *y, int count) {
+    const int layers = model->layers;
+    memcpy(model->act[0], x, count * sizeof(float));
+    mlp_forward_batch(model, count);
+
+    // Output gradient: d(mean loss)/d(prediction)
+    float loss = 0.0f;
+    const float *pred = model->act[layers];
+    float *g = model->grad[layers];
+    for (int i = 0; i < count; i++) {
+        float grad;
+        loss += ai_block_loss_factor(pred[i] - y[i], core->loss_type, core->huber_delta, &grad);
+        g[i] = grad / count;
+    }
+
+    for (int l = layers - 1; l >= 0; l--) {
+        int in = model->width[l], out = model->width[l + 1];
+        const float *upstream = model->grad[l + 1];
+
+        // dW = act[l]^T * grad[l + 1], db = column sums of grad[l + 1]
+        transpose(count, in, model->act[l], model->scratch);
+        gemm(in, out, count, model->scratch, count, upstream, out, model->dw[l], out, 0);
+        float *db = model->db[l];
+        memset(db, 0, out * sizeof(float));
+        for (int i = 0; i < count; i++) {
+            for (int j = 0; j < out; j++) db[j] += upstream[(size_t)i * out + j];
+        }
+
+        // grad[l] = grad[l + 1] * W^T, times the activation derivative
+        if (l > 0) {
+            transpose(in, out, model->w[l], model->scratch);
+            gemm(count, in, out, upstream, out, model->scratch, in, model->grad[l], in, 0);
+            const float *a = model->act[l];
+            float *gl = model->grad[l];
+            for (size_t i = 0; i < (size_t)count * in; i++) {
+                gl[i] *= model->activation == MLP_TANH ? 1.0f - a[i] * a[i] : (a[i] > 0.0f ? 1.0f : 0.0f);
+            }
+        }
+    }
+
+    const float lambda = core->regularization_lambda, rate = core->learning_rate;
+    float reg = 0.0f;
+    for (int l = 0; l < layers; l++) {
+        float *params[2] = { model->w[l], model->b[l] };
+        const float *grads[2] = { model->dw[l], model->db[l] };
+        size_t sizes[2] = { (size_t)model->width[l] * model->width[l + 1], (size_t)model->width[l + 1] };
+        for (int t = 0; t < 2; t++) {
+            float *p = params[t];
+            const float *dp = grads[t];
+            for (size_t i = 0; i < sizes[t]; i++) {
+                float d = dp[i];
+                if (lambda > 0.0f) {
+                    reg += p[i] * p[i];
+                    d += lambda * p[i];
+                }
+                d = d > GRADIENT_CLIP ? GRADIENT_CLIP : (d < -GRADIENT_CLIP ? -GRADIENT_CLIP : d);
+                p[i] -= rate * d;
+            }
+        }
+    }
+    return loss + count * lambda * reg / 2.0f;
+}
+
+// Single-sample step ('learn' and the server's learn requests)
+void mlp_learn(AICore *core, float x, float y) {
+    mlp_train_batch(core->mlp, core, &x, &y, 1);
+}
+
+// One epoch of mini-batches over the dataset in order. Returns the average loss.
+float mlp_epoch(AICore *core, const Dataset *data) {
+    MlpModel *model = core->mlp;
+    double total = 0.0;
+    for (size_t start = 0; start < data->size; start += DATASET_CHUNK) {
+        DatasetChunk chunk;
+        size_t count = dataset_chunk(data, start, DATASET_CHUNK, &chunk);
+        for (size_t i = 0; i < count; i += model->batch) {
+            int n = count - i < (size_t)model->batch ? (int)(count - i) : model->batch;
+            total += mlp_train_batch(model, core, chunk.x + i, chunk.y + i, n);
+        }
+    }
+    return data->size > 0 ? (float)(total / data->size) : 0.0f;
+}
+
+// Mean loss (with L2) of the model over a dataset, without training
+float mlp_evaluate(AICore *core, const Dataset *data) {
+    MlpModel *model = core->mlp;
+    double total = 0.0;
+    for (size_t start = 0; start < data->size; start += DATASET_CHUNK) {
+        DatasetChunk chunk;
+        size_t count = dataset_chunk(data, start, DATASET_CHUNK, &chunk);
+        for (size_t i = 0; i < count; i += model->batch) {
+            int n = count - i < (size_t)model->batch ? (int)(count - i) : model->batch;
+            memcpy(model->act[0], chunk.x + i, n * sizeof(float));
+            mlp_forward_batch(model, n);
+            for (int s = 0; s < n; s++) {
+                float grad;
+                total += ai_block_loss_factor(model->act[model->layers][s] - chunk.y[i + s],
+                                              core->loss_type, core->huber_delta, &grad);
+            }
+        }
+    }
+    return data->size > 0 ? (float)(total / data->size) : 0.0f;
+}
+
+// Benchmark
+
+static double mlp_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Time C = A * B for m x k by k x n with the blocked kernel and the plain
+// loop, check they agree and report GFLOP/s
+static void mlp_bench_shape(int m, int n, int k) {
+    float *a = aligned_alloc(64, (((size_t)m * k * sizeof(float)) + 63) & ~(size_t)63);
+    float *b = aligned_alloc(64, (((size_t)k * n * sizeof(float)) + 63) & ~(size_t)63);
+    float *c = aligned_alloc(64, (((size_t)m * n * sizeof(float)) + 63) & ~(size_t)63);
+    float *ref = aligned_alloc(64, (((size_t)m * n * sizeof(float)) + 63) & ~(size_t)63);
+    if (!a || !b || !c || !ref) {
+        printf("  %4dx%4dx%4d: allocation failed\n", m, n, k);
+        free(a); free(b); free(c); free(ref);
+        return;
+    }
+    uint64_t state = 1;
+    for (size_t i = 0; i < (size_t)m * k; i++) a[i] = (float)(mlp_random(&state) >> 40) / 16777216.0f - 0.5f;
+    for (size_t i = 0; i < (size_t)k * n; i++) b[i] = (float)(mlp_random(&state) >> 40) / 16777216.0f - 0.5f;
+
+    double flops = 2.0 * m * n * k;
+    int reps = (int)(2e8 / flops) + 1;
+    double seconds[2];
+    for (int variant = 0; variant < 2; variant++) {
+        double start = mlp_now();
+        for (int r = 0; r < reps; r++) {
+            if (variant == 0) gemm(m, n, k, a, k, b, n, c, n, 0);
+            else gemm_scalar(m, n, k, a, k, b, n, ref, n, 0);
+        }
+        seconds[variant] = mlp_now() - start;
+    }
+
+    float max_error = 0.0f;
+    for (size_t i = 0; i < (size_t)m * n; i++) {
+        float e = fabsf(c[i] - ref[i]);
+        if (e > max_error) max_error = e;
+    }
+    printf("  %4dx%4dx%4d: %7.2f GFLOP/s blocked, %7.2f GFLOP/s plain, max diff %.2e\n", m, n, k,
+           flops * reps / seconds[0] / 1e9, flops * reps / seconds[1] / 1e9, max_error);
+    free(a); free(b); free(c); free(ref);
+}
+
+// 'mlp bench [size]': the shapes a training step runs, and a square product
+void mlp_bench(int size) {
+    if (size < 1) size = 64;
+    printf("GEMM kernel: %s\n", mlp_has_avx2() ? "AVX2/FMA 4x16 blocked" : "scalar");
+    mlp_bench_shape(MLP_DEFAULT_BATCH, size, size);   // Hidden layer forward
+    mlp_bench_shape(size, size, MLP_DEFAULT_BATCH);   // Weight gradient
+    mlp_bench_shape(MLP_MAX_BATCH, size, size);
+    mlp_bench_shape(size, size, size);
+}
+
+// 'mlp' command: mlp <core_id> <h1[,h2..]> [relu|tanh] [batch] | mlp <core_id> off | mlp bench [size]
+int mlp_command(OneCoreCtx *ctx, int argc, char **argv) {
+    if (strcmp(argv[1], "bench") == 0) {
+        mlp_bench(argc >= 3 ? atoi(argv[2]) : 64);
+        return 0;
+    }
+
+    int core_id = atoi(argv[1]);
+    AICore *core = core_get(ctx, core_id);
+    if (!core) {
+        printf("Invalid core ID: %d\n", core_id);
+        return -1;
+    }
+    if (argc < 3) {
+        char model[128];
+        if (core->type == CORE_MLP) mlp_describe(core->mlp, model, sizeof(model));
+        printf("Core %d model: %s%s\n", core_id, core->type == CORE_MLP ? "MLP " : "linear",
+               core->type == CORE_MLP ? model : "");
+        return 0;
+    }
+
+    MlpModel *model = NULL;
+    if (strcmp(argv[2], "off") != 0) {
+        int hidden[MLP_MAX_HIDDEN];
+        int count = 0;
+        char widths[128], *save = NULL;
+        snprintf(widths, sizeof(widths), "%s", argv[2]);
+        for (char *tok = strtok_r(widths, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+            if (count == MLP_MAX_HIDDEN) {
+                printf("At most %d hidden layers.\n", MLP_MAX_HIDDEN);
+                return -1;
+            }
+            hidden[count++] = atoi(tok);
+        }
+
+        MlpActivation activation = MLP_RELU;
+        if (argc >= 4 && strcmp(argv[3], "tanh") == 0) {
+            activation = MLP_TANH;
+        } else if (argc >= 4 && strcmp(argv[3], "relu") != 0) {
+            printf("Unknown activation: %s (relu or tanh)\n", argv[3]);
+            return -1;
+        }
+        int batch = argc >= 5 ? atoi(argv[4]) : MLP_DEFAULT_BATCH;
+        if (batch < 1 || batch > MLP_MAX_BATCH) {
+            printf("Batch size must be 1-%d.\n", MLP_MAX_BATCH);
+            return -1;
+        }
+
+        model = mlp_create(hidden, count, activation, batch, (uint64_t)core_id);
+        if (!model) {
+            printf("Invalid hidden layers: %s (1-%d layers of 1-%d units)\n",
+                   argv[2], MLP_MAX_HIDDEN, MLP_MAX_WIDTH);
+            return -1;
+        }
+    }
+
+    // Swap models under the core lock so a running training call keeps its own
+    core_lock(ctx, core_id);
+    mlp_free(core->mlp);
+    core->mlp = model;
+    core->type = model ? CORE_MLP : CORE_LINEAR;
+    core->trained = 0;
+    stream_restart(core);
+    snapshot_publish_core(ctx, core);
+    core_unlock(ctx, core_id);
+
+    if (model) {
+        char description[128];
+        mlp_describe(model, description, sizeof(description));
+        printf("Core %d is now an MLP: %s\n", core_id, description);
+    } else {
+        printf("Core %d is now a linear core.\n", core_id);
+    }
+    return 0;
+}
@@ -0,0 +1,513 @@
+/*
+
+    OneCoreAI - NUMA-Aware Parallel Training
+
+    Trains several cores at once on worker threads pinned to CPUs. The
+    topology comes straight from /sys/devices/system/node (no libnuma).
+    Read-only training data is either replicated into memory local to
+    each node (first touch by a worker pinned there), interleaved across
+    nodes with mbind(), or left where it was allocated; cores are queued
+    on the node that holds their data and taken by that node's workers.
+    Bytes streamed per node are recorded so runs report per-node bandwidth.
+
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include "handle.h"
+#include "context.h"
+#include "trace.h"
+
+#define NUMA_MAX_CPUS 1024
+
+#ifndef MPOL_INTERLEAVE
+#define MPOL_INTERLEAVE 3
+#endif
+#ifndef MPOL_MF_MOVE
+#define MPOL_MF_MOVE (1 << 1)
+#endif
+#ifndef MPOL_F_NODE
+#define MPOL_F_NODE (1 << 0)
+#endif
+#ifndef MPOL_F_ADDR
+#define MPOL_F_ADDR (1 << 1)
+#endif
+
+typedef struct {
+    int id;                       // Node number in /sys
+    int cpus[NUMA_MAX_CPUS];
+    int cpu_count;
+} NumaNode;
+
+static struct {
+    NumaNode nodes[NUMA_MAX_NODES];
+    int node_count;
+    short cpu_node[NUMA_MAX_CPUS];   // Index into nodes[] for each CPU
+} topology;
+
+// The machine's topology is shared; placement, worker count and the last
+// run's per-node results belong to each context
+static pthread_once_t topology_once = PTHREAD_ONCE_INIT;
+
+static const char *policy_names[] = { "local", "replicate", "interleave" };
+
+static double numa_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Parse a /sys cpulist such as "0-3,8-11" into cpus[]
+static int parse_cpulist(const char *list, int *cpus, int max) {
+    int count = 0;
+    const char *p = list;
+    while (*p && *p != '\n') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p) break;
+        long last = first;
+        if (*end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+        }
+        for (long cpu = first; cpu <= last && count < max; cpu++) {
+            if (cpu >= 0 && cpu < NUMA_MAX_CPUS) cpus[count++] = (int)cpu;
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+static int read_line(const char *path, char *buf, size_t size) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    int ok = fgets(buf, (int)size, file) != NULL;
+    fclose(file);
+    return ok ? 0 : -1;
+}
+
+static void numa_discover() {
+    char buf[4096], path[128];
+    int node_ids[NUMA_MAX_CPUS];
+    int ids = 0;
+
+    if (read_line("/sys/devices/system/node/online", buf, sizeof(buf)) == 0) {
+        ids = parse_cpulist(buf, node_ids, NUMA_MAX_CPUS);
+    }
+    for (int i = 0; i < ids && topology.node_count < NUMA_MAX_NODES; i++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node_ids[i]);
+        if (read_line(path, buf, sizeof(buf)) != 0) continue;
+
+        NumaNode *node = &topology.nodes[topology.node_count];
+        node->id = node_ids[i];
+        node->cpu_count = parse_cpulist(buf, node->cpus, NUMA_MAX_CPUS);
+        if (node->cpu_count > 0) topology.node_count++;  // Skip memory-only nodes
+    }
+
+    // No NUMA information: one node with every online CPU
+    if (topology.node_count == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        NumaNode *node = &topology.nodes[0];
+        node->id = 0;
+        node->cpu_count = online > 0 ? (online < NUMA_MAX_CPUS ? (int)online : NUMA_MAX_CPUS) : 1;
+        for (int i = 0; i < node->cpu_count; i++) node->cpus[i] = i;
+        topology.node_count = 1;
+    }
+
+    for (int n = 0; n < topology.node_count; n++) {
+        for (int i = 0; i < topology.nodes[n].cpu_count; i++) {
+            topology.cpu_node[topology.nodes[n].cpus[i]] = (short)n;
+        }
+    }
+}
+
+// Node (index into the topology) of the calling thread
+static int numa_current_node() {
+    int cpu = sched_getcpu();
+    return cpu >= 0 && cpu < NUMA_MAX_CPUS ? topology.cpu_node[cpu] : 0;
+}
+
+// Node (index into the topology) holding the page at addr, or fallback
+static int numa_node_of(const void *addr, int fallback) {
+    int id = -1;
+    if (!addr || syscall(SYS_get_mempolicy, &id, NULL, 0UL, addr, MPOL_F_NODE | MPOL_F_ADDR) != 0) {
+        return fallback;
+    }
+    for (int n = 0; n < topology.node_count; n++) {
+        if (topology.nodes[n].id == id) return n;
+    }
+    return fallback;
+}
+
+// Spread a buffer's pages across every node
+static void numa_interleave(void *addr, size_t len) {
+    if (len == 0 || topology.node_count < 2) {
+        return;
+    }
+    long page = sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)addr & ~(uintptr_t)(page - 1);
+    uintptr_t end = ((uintptr_t)addr + len + page - 1) & ~(uintptr_t)(page - 1);
+
+    unsigned long mask[NUMA_MAX_CPUS / (8 * sizeof(unsigned long))] = { 0 };
+    for (int n = 0; n < topology.node_count; n++) {
+        int id = topology.nodes[n].id;
+        mask[id / (8 * sizeof(unsigned long))] |= 1ul << (id % (8 * sizeof(unsigned long)));
+    }
+    syscall(SYS_mbind, (void *)start, end - start, MPOL_INTERLEAVE, mask,
+            (unsigned long)NUMA_MAX_CPUS, MPOL_MF_MOVE);
+}
+
+// Parallel run state
+
+typedef struct NumaRun NumaRun;
+
+typedef struct {
+    NumaRun *run;
+    int node;
+    int cpu;
+    int leader;                      // Builds the node's replica
+    int cores;                       // Cores trained
+    double bytes;
+    double seconds;
+    pthread_t thread;
+} NumaWorker;
+
+struct NumaRun {
+    OneCoreCtx *ctx;
+    TrainControl *control;           // Caller's job control, or `headless`
+    TrainControl headless;
+    const Dataset *source;
+    int source_node;                 // Node holding the source's pages (-1: several or none)
+    Dataset replicas[NUMA_MAX_NODES];
+    int has_replica[NUMA_MAX_NODES];
+    int queue[NUMA_MAX_NODES][MAX_CORES];
+    int queue_len[NUMA_MAX_NODES];
+    _Atomic int queue_next[NUMA_MAX_NODES];
+    pthread_mutex_t gate;            // Workers wait here until the barriers are sized
+    pthread_cond_t open;
+    int go;
+    pthread_barrier_t replicated;
+    pthread_barrier_t trained;
+    _Atomic int failures;
+};
+
+static void numa_pin(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// Train every core queued on this worker's node
+static void numa_train_queue(NumaWorker *worker, const Dataset *data) {
+    NumaRun *run = worker->run;
+    double start = numa_now();
+
+    while (!(run->control && atomic_load(&run->control->cancel))) {
+        int index = atomic_fetch_add(&run->queue_next[worker->node], 1);
+        if (index >= run->queue_len[worker->node]) break;
+
+        int core_id = run->queue[worker->node][index];
+        AICore *core = core_get(run->ctx, core_id);
+        if (!core) {
+            printf("Invalid core ID: %d\n", core_id);
+            atomic_fetch_add(&run->failures, 1);
+            continue;
+        }
+        core_lock(run->ctx, core_id);
+        if (ai_block_train_dataset(run->ctx, core, data, 0) == 0) {
+            worker->cores++;
+        } else {
+            atomic_fetch_add(&run->failures, 1);
+        }
+        worker->bytes += (double)dataset_bytes(data) * core->epochs;
+        core_unlock(run->ctx, core_id);
+    }
+    worker->seconds = numa_now() - start;
+}
+
+// Cores still queued when the run was cancelled were never trained
+static void numa_count_skipped(NumaRun *run) {
+    for (int n = 0; n < NUMA_MAX_NODES; n++) {
+        int next = atomic_load(&run->queue_next[n]);
+        if (next < run->queue_len[n]) {
+            atomic_fetch_add(&run->failures, run->queue_len[n] - next);
+        }
+    }
+}
+
+static void *numa_worker(void *arg) {
+    NumaWorker *worker = arg;
+    NumaRun *run = worker->run;
+    Arena *arena = NULL;
+
+    numa_pin(worker->cpu);
+    ai_block_set_control(run->control);
+    trace_name_thread("numa worker cpu %d", worker->cpu);
+
+    pthread_mutex_lock(&run->gate);
+    while (!run->go) {
+        pthread_cond_wait(&run->open, &run->gate);
+    }
+    pthread_mutex_unlock(&run->gate);
+
+    // The leader copies the dataset into memory it touches first, so the
+    // pages land on this node. A single node, the node already holding the
+    // data and implicit data (no pages) gain nothing from a copy.
+    if (worker->leader && run->ctx->numa_policy == NUMA_REPLICATE && topology.node_count >= 2 &&
+        worker->node != run->source_node && !dataset_is_implicit(run->source)) {
+        arena = arena_run_begin(dataset_arena_size(run->source->size, run->source->precision));
+        if (dataset_clone(&run->replicas[worker->node], run->source, arena) == 0) {
+            run->has_replica[worker->node] = 1;
+        }
+    }
+    pthread_barrier_wait(&run->replicated);
+
+    const Dataset *data = run->has_replica[worker->node] ? &run->replicas[worker->node] : run->source;
+    numa_train_queue(worker, data);
+
+    // Keep replicas alive until every worker is done with them
+    pthread_barrier_wait(&run->trained);
+    if (worker->leader && run->has_replica[worker->node]) {
+        dataset_free(&run->replicas[worker->node]);
+    }
+    arena_run_end(arena);
+    return NULL;
+}
+
+// Train the given cores in parallel on NUMA-pinned workers. Returns the
+// number of cores that could not be trained.
+int numa_train_cores(OneCoreCtx *ctx, const int *core_ids, int count, const Dataset *data) {
+    pthread_once(&topology_once, numa_discover);
+
+    NumaRun *run = calloc(1, sizeof(NumaRun));
+    NumaWorker *workers = NULL;
+    if (!run) {
+        printf("Failed to allocate training run.\n");
+        return count;
+    }
+    run->ctx = ctx;
+    run->control = ai_block_control();
+    run->source = data;
+    run->source_node = -1;
+
+    // Queue each core on a node that holds the data
+    int home = numa_current_node();
+    if (ctx->numa_policy == NUMA_REPLICATE && topology.node_count >= 2 && !dataset_is_implicit(data)) {
+        int node = numa_node_of(data->x, -1);
+        run->source_node = node == numa_node_of(data->y, -2) ? node : -1;
+    }
+    int nodes[NUMA_MAX_NODES], node_count = 0;
+    if (ctx->numa_policy == NUMA_LOCAL || topology.node_count == 1) {
+        nodes[node_count++] = home;
+    } else {
+        for (int n = 0; n < topology.node_count; n++) nodes[node_count++] = n;
+    }
+    for (int i = 0; i < count; i++) {
+        int node = nodes[i % node_count];
+        run->queue[node][run->queue_len[node]++] = core_ids[i];
+    }
+
+    // Workers: one per CPU, never more than the cores queued on a node; an
+    // explicit worker count may put several on one CPU
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    int budget = ctx->numa_workers > 0 ? ctx->numa_workers : (online > 0 ? (int)online : 1);
+    if (budget > count) budget = count;
+    int per_node[NUMA_MAX_NODES] = { 0 };
+    int total = 0;
+    for (int progress = 1; progress && total < budget; ) {
+        progress = 0;
+        for (int i = 0; i < node_count && total < budget; i++) {
+            int n = nodes[i];
+            int cpu_limit = ctx->numa_workers > 0 || per_node[n] < topology.nodes[n].cpu_count;
+            if (per_node[n] < run->queue_len[n] && cpu_limit) {
+                per_node[n]++;
+                total++;
+                progress = 1;
+            }
+        }
+    }
+    if (total == 0) {
+        free(run);
+        return 0;
+    }
+
+    pthread_mutex_lock(&ctx->numa_stats_lock);
+    memset(ctx->numa_last_run, 0, sizeof(ctx->numa_last_run));
+    ctx->numa_last_run_valid = 0;
+    pthread_mutex_unlock(&ctx->numa_stats_lock);
+
+    if (total == 1) {
+        // One worker: train on this thread, as before, keeping the visualization
+        NumaWorker worker = { .run = run, .node = home };
+        double seconds = 0.0;
+        for (int i = 0; i < node_count; i++) {
+            worker.node = nodes[i];
+            numa_train_queue(&worker, data);
+            seconds += worker.seconds;
+        }
+        pthread_mutex_lock(&ctx->numa_stats_lock);
+        ctx->numa_last_run[home] = (NumaNodeStats){ 1, worker.cores, worker.bytes, seconds };
+        ctx->numa_last_run_valid = 1;
+        pthread_mutex_unlock(&ctx->numa_stats_lock);
+        numa_count_skipped(run);
+        int failures = atomic_load(&run->failures);
+        free(run);
+        return failures;
+    }
+
+    workers = calloc(total, sizeof(NumaWorker));
+    if (!workers) {
+        free(run);
+        printf("Failed to allocate training workers.\n");
+        return count;
+    }
+
+    if (ctx->numa_policy == NUMA_INTERLEAVE && !dataset_is_implicit(data)) {
+        size_t elem = data->precision == PRECISION_FP32 ? sizeof(float) : sizeof(uint16_t);
+        numa_interleave(data->x, data->size * elem);
+        numa_interleave(data->y, data->size * elem);
+        numa_interleave(data->data_sheet, data->size);
+    }
+
+    // Redrawing the visualization from several threads would garble it
+    if (!run->control) {
+        run->headless.headless = 1;
+        run->control = &run->headless;
+    }
+
+    int w = 0;
+    for (int i = 0; i < node_count; i++) {
+        int n = nodes[i];
+        for (int k = 0; k < per_node[n]; k++, w++) {
+            workers[w] = (NumaWorker){
+                .run = run, .node = n, .leader = k == 0,
+                .cpu = topology.nodes[n].cpus[k % topology.nodes[n].cpu_count]
+            };
+        }
+    }
+
+    pthread_mutex_init(&run->gate, NULL);
+    pthread_cond_init(&run->open, NULL);
+    int started = 0;
+    for (; started < total; started++) {
+        if (pthread_create(&workers[started].thread, NULL, numa_worker, &workers[started]) != 0) {
+            printf("Failed to start %d training worker(s).\n", total - started);
+            break;
+        }
+    }
+
+    // Size the barriers to the workers that actually started, then let them go
+    if (started > 0) {
+        pthread_barrier_init(&run->replicated, NULL, started);
+        pthread_barrier_init(&run->trained, NULL, started);
+    }
+    pthread_mutex_lock(&run->gate);
+    run->go = 1;
+    pthread_cond_broadcast(&run->open);
+    pthread_mutex_unlock(&run->gate);
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    // Cores left on a node whose workers failed to start train here
+    for (int n = 0; n < topology.node_count; n++) {
+        if (atomic_load(&run->queue_next[n]) < run->queue_len[n]) {
+            NumaWorker fallback = { .run = run, .node = n };
+            numa_train_queue(&fallback, data);
+            pthread_mutex_lock(&ctx->numa_stats_lock);
+            ctx->numa_last_run[n].cores += fallback.cores;
+            ctx->numa_last_run[n].bytes += fallback.bytes;
+            ctx->numa_last_run[n].seconds += fallback.seconds;
+            pthread_mutex_unlock(&ctx->numa_stats_lock);
+        }
+    }
+
+    pthread_mutex_lock(&ctx->numa_stats_lock);
+    for (int i = 0; i < started; i++) {
+        NumaNodeStats *stats = &ctx->numa_last_run[workers[i].node];
+        stats->workers++;
+        stats->cores += workers[i].cores;
+        stats->bytes += workers[i].bytes;
+        if (workers[i].seconds > stats->seconds) stats->seconds = workers[i].seconds;
+    }
+    ctx->numa_last_run_valid = 1;
+    NumaNodeStats last_run[NUMA_MAX_NODES];
+    memcpy(last_run, ctx->numa_last_run, sizeof(last_run));
+    pthread_mutex_unlock(&ctx->numa_stats_lock);
+
+    for (int n = 0; n < topology.node_count; n++) {
+        if (last_run[n].cores == 0) continue;
+        printf("NUMA node %d: %d core(s) on %d worker(s), %.1f MB streamed in %.3f s (%.2f GB/s, %s)\n",
+               topology.nodes[n].id, last_run[n].cores, last_run[n].workers, last_run[n].bytes / 1e6,
+               last_run[n].seconds, last_run[n].seconds > 0 ? last_run[n].bytes / last_run[n].seconds / 1e9 : 0.0,
+               run->has_replica[n] ? "local replica" : policy_names[ctx->numa_policy]);
+    }
+
+    if (started > 0) {
+        pthread_barrier_destroy(&run->replicated);
+        pthread_barrier_destroy(&run->trained);
+    }
+    pthread_mutex_destroy(&run->gate);
+    pthread_cond_destroy(&run->open);
+    numa_count_skipped(run);
+    int failures = atomic_load(&run->failures);
+    free(workers);
+    free(run);
+    return failures;
+}
+
+// 'numa local|replicate|interleave'
+int numa_set_policy(OneCoreCtx *ctx, const char *name) {
+    for (int i = NUMA_LOCAL; i <= NUMA_INTERLEAVE; i++) {
+        if (strcmp(name, policy_names[i]) == 0) {
+            ctx->numa_policy = (NumaPolicy)i;
+            printf("Training data placement: %s\n", policy_names[i]);
+            return 0;
+        }
+    }
+    printf("Unknown placement: %s (local, replicate or interleave)\n", name);
+    return -1;
+}
+
+// 'numa workers <n>' (0: one per CPU)
+void numa_set_workers(OneCoreCtx *ctx, int workers) {
+    ctx->numa_workers = workers > 0 ? workers : 0;
+    if (ctx->numa_workers > 0) printf("Training workers: %d\n", ctx->numa_workers);
+    else printf("Training workers: one per CPU\n");
+}
+
+// 'numa': topology, placement and per-node bandwidth of the last run
+void numa_report(OneCoreCtx *ctx) {
+    pthread_once(&topology_once, numa_discover);
+
+    printf("NUMA nodes: %d, placement: %s, workers: ", topology.node_count, policy_names[ctx->numa_policy]);
+    if (ctx->numa_workers > 0) printf("%d\n", ctx->numa_workers);
+    else printf("one per CPU\n");
+
+    pthread_mutex_lock(&ctx->numa_stats_lock);
+    for (int n = 0; n < topology.node_count; n++) {
+        const NumaNode *node = &topology.nodes[n];
+        printf("  Node %d: %d CPU(s) [%d", node->id, node->cpu_count, node->cpus[0]);
+        if (node->cpu_count > 1) printf("..%d", node->cpus[node->cpu_count - 1]);
+        printf("]");
+        const NumaNodeStats *last = &ctx->numa_last_run[n];
+        if (ctx->numa_last_run_valid && last->workers > 0) {
+            printf(", last run %d core(s), %.2f GB/s", last->cores,
+                   last->seconds > 0 ? last->bytes / last->seconds / 1e9 : 0.0);
+        }
+        printf("\n");
+    }
+    pthread_mutex_unlock(&ctx->numa_stats_lock);
+}
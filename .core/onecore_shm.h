@@ -0,0 +1,108 @@
+/*
+
+    OneCoreAI shared-memory parameter table and reader library.
+
+    The `publish <name>` command maps the table below into a POSIX shared
+    memory segment (/dev/shm/<name>) and keeps it current after every train,
+    learn or reconfiguration. Consumers include this header, map the segment
+    once with onecore_shm_open() and then read parameters straight out of
+    the mapping: no syscalls, no locks, no copies beyond the values returned.
+
+    Each entry is guarded by a sequence counter (odd while being written),
+    so readers retry instead of ever seeing a torn (weight, bias) pair.
+    Only linear cores have a (weight, bias) model: MLP entries carry
+    ONECORE_SHM_TYPE_MLP and are never marked trained.
+
+*/
+
+#ifndef ONECORE_SHM_H
+#define ONECORE_SHM_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define ONECORE_SHM_MAGIC 0x4941434Fu   // "OCAI"
+#define ONECORE_SHM_LAYOUT 2
+#define ONECORE_SHM_MAX_CORES 30
+
+// Entry types
+#define ONECORE_SHM_TYPE_LINEAR 0
+#define ONECORE_SHM_TYPE_MLP 1
+
+// Parameters of one core, padded to a cache line
+typedef struct {
+    _Alignas(64) _Atomic uint32_t seq;  // Odd while being written, seq/2 = publish count
+    float weight;
+    float bias;
+    float learning_rate;
+    int32_t epochs;
+    int32_t trained;                    // 0 for MLP cores, whose weight and bias are unused
+    int32_t type;                       // ONECORE_SHM_TYPE_*
+} OneCoreShmEntry;
+
+typedef struct {
+    uint32_t magic;                     // ONECORE_SHM_MAGIC
+    uint32_t layout;                    // ONECORE_SHM_LAYOUT
+    uint32_t max_cores;
+    _Atomic uint32_t core_count;        // Cores 1..core_count are valid
+    _Atomic uint64_t generation;        // Bumped after every publish
+    OneCoreShmEntry entries[ONECORE_SHM_MAX_CORES];
+} OneCoreShmTable;
+
+// Map a published table read-only. Returns NULL if missing or incompatible.
+static inline const OneCoreShmTable *onecore_shm_open(const char *name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return 0;
+
+    void *map = mmap(0, sizeof(OneCoreShmTable), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+
+    const OneCoreShmTable *table = (const OneCoreShmTable *)map;
+    if (table->magic != ONECORE_SHM_MAGIC || table->layout != ONECORE_SHM_LAYOUT) {
+        munmap(map, sizeof(OneCoreShmTable));
+        return 0;
+    }
+    return table;
+}
+
+static inline void onecore_shm_close(const OneCoreShmTable *table) {
+    if (table) munmap((void *)table, sizeof(OneCoreShmTable));
+}
+
+// Generation counter: changes whenever any core is republished
+static inline uint64_t onecore_shm_generation(const OneCoreShmTable *table) {
+    return atomic_load_explicit((_Atomic uint64_t *)&table->generation, memory_order_acquire);
+}
+
+// Number of valid cores (IDs 1..count)
+static inline uint32_t onecore_shm_core_count(const OneCoreShmTable *table) {
+    return atomic_load_explicit((_Atomic uint32_t *)&table->core_count, memory_order_acquire);
+}
+
+// Read a consistent (weight, bias, ...) for core_id. Returns the entry's
+// publish count, or 0 if the core ID is not valid.
+static inline uint32_t onecore_shm_read(const OneCoreShmTable *table, int core_id,
+                                        float *weight, float *bias, int *trained) {
+    if (core_id < 1 || (uint32_t)core_id > onecore_shm_core_count(table)) return 0;
+
+    const OneCoreShmEntry *entry = &table->entries[core_id - 1];
+    _Atomic uint32_t *seq = (_Atomic uint32_t *)&entry->seq;
+    uint32_t before, after;
+    do {
+        before = atomic_load_explicit(seq, memory_order_acquire);
+        *weight = entry->weight;
+        *bias = entry->bias;
+        *trained = entry->trained;
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(seq, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    return before / 2;
+}
+
+#endif
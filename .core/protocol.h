@@ -0,0 +1,52 @@
+/*
+
+    Wire protocol for the OneCoreAI prediction server.
+
+    Every message is a fixed 8-byte header followed by `count` 32-bit floats,
+    in host byte order (the server only listens on a Unix socket or loopback).
+    Requests may be pipelined; responses come back in request order and echo
+    the request tag.
+
+*/
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdint.h>
+
+// Maximum number of float values in one message
+#define SERVER_MAX_VALUES 1024
+
+// Request operations
+typedef enum {
+    SERVER_OP_PREDICT = 1,        // values: x               -> prediction
+    SERVER_OP_BATCH_PREDICT = 2,  // values: x[count]        -> predictions[count]
+    SERVER_OP_LEARN = 3,          // values: (x, y)[count/2] -> weight, bias
+    SERVER_OP_FETCH = 4           // values: none            -> weight, bias, lr, epochs
+} ServerOp;
+
+// Response status codes
+typedef enum {
+    SERVER_OK = 0,
+    SERVER_ERR_CORE = 1,          // Invalid core ID
+    SERVER_ERR_UNTRAINED = 2,     // Core has not been trained yet
+    SERVER_ERR_REQUEST = 3,       // Unknown operation or bad value count
+    SERVER_ERR_TYPE = 4,          // MLP core: the server only evaluates linear cores
+    SERVER_ERR_BUSY = 5           // Learn: the core is training, try again later
+} ServerStatus;
+
+typedef struct {
+    uint8_t op;          // ServerOp
+    uint8_t core_id;
+    uint16_t count;      // Number of floats that follow
+    uint32_t tag;        // Echoed back in the response
+} ServerRequest;
+
+typedef struct {
+    uint8_t status;      // ServerStatus
+    uint8_t op;
+    uint16_t count;      // Number of floats that follow
+    uint32_t tag;
+} ServerResponse;
+
+#endif
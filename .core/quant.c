@@ -0,0 +1,241 @@
+/*
+
+    OneCoreAI - Quantized Inference
+
+    Converts a trained core (or the ensemble of several cores) to fixed-point
+    parameters: the weight becomes an int16 with its own scale and inputs are
+    stored as int8 or int16 with a scale calibrated from sample data. Batched
+    inference multiplies in integer SIMD lanes (AVX2 when the CPU has it) and
+    rescales once per lane to produce float predictions.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "handle.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define QUANT_HAVE_X86 1
+#endif
+
+// Build a quantized model from float parameters, calibrating the input
+// scale on the given samples. bits is 8 or 16.
+int quant_model_init(QuantModel *model, float weight, float bias, int bits,
+                     const float *calibration, size_t count) {
+    if (bits != 8 && bits != 16) {
+        return -1;
+    }
+
+    float max_abs = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        float a = fabsf(calibration[i]);
+        if (a > max_abs) max_abs = a;
+    }
+    if (max_abs == 0.0f) max_abs = 1.0f;
+
+    int input_max = bits == 8 ? 127 : 32767;
+    float weight_abs = fabsf(weight) > 0.0f ? fabsf(weight) : 1.0f;
+
+    model->bits = bits;
+    model->input_scale = max_abs / input_max;
+    model->weight_scale = weight_abs / 32767.0f;
+    model->weight_q = (int16_t)lrintf(weight / model->weight_scale);
+    model->output_scale = model->input_scale * model->weight_scale;
+    model->bias = bias;
+    return 0;
+}
+
+// Quantize inputs to the model's fixed-point format (int8_t or int16_t array)
+void quant_quantize_inputs(const QuantModel *model, const float *x, void *x_q, size_t count) {
+    float inv = 1.0f / model->input_scale;
+    int limit = model->bits == 8 ? 127 : 32767;
+
+    for (size_t i = 0; i < count; i++) {
+        long v = lrintf(x[i] * inv);
+        if (v > limit) v = limit;
+        if (v < -limit) v = -limit;
+        if (model->bits == 8) ((int8_t *)x_q)[i] = (int8_t)v;
+        else ((int16_t *)x_q)[i] = (int16_t)v;
+    }
+}
+
+static void quant_predict_scalar(const QuantModel *model, const void *x_q, float *out,
+                                 size_t start, size_t count) {
+    int32_t w = model->weight_q;
+    for (size_t i = start; i < count; i++) {
+        int32_t x = model->bits == 8 ? ((const int8_t *)x_q)[i] : ((const int16_t *)x_q)[i];
+        out[i] = (float)(x * w) * model->output_scale + model->bias;
+    }
+}
+
+#ifdef QUANT_HAVE_X86
+// 8 predictions per step: widen to int32, integer multiply, rescale once
+__attribute__((target("avx2,fma")))
+static size_t quant_predict_avx2(const QuantModel *model, const void *x_q, float *out, size_t count) {
+    __m256i w = _mm256_set1_epi32(model->weight_q);
+    __m256 scale = _mm256_set1_ps(model->output_scale);
+    __m256 bias = _mm256_set1_ps(model->bias);
+    size_t i = 0;
+
+    if (model->bits == 8) {
+        const int8_t *x = x_q;
+        for (; i + 32 <= count; i += 32) {
+            __m256i bytes = _mm256_loadu_si256((const __m256i *)(x + i));
+            __m128i lo = _mm256_castsi256_si128(bytes);
+            __m128i hi = _mm256_extracti128_si256(bytes, 1);
+            __m256i p0 = _mm256_mullo_epi32(_mm256_cvtepi8_epi32(lo), w);
+            __m256i p1 = _mm256_mullo_epi32(_mm256_cvtepi8_epi32(_mm_srli_si128(lo, 8)), w);
+            __m256i p2 = _mm256_mullo_epi32(_mm256_cvtepi8_epi32(hi), w);
+            __m256i p3 = _mm256_mullo_epi32(_mm256_cvtepi8_epi32(_mm_srli_si128(hi, 8)), w);
+            _mm256_storeu_ps(out + i, _mm256_fmadd_ps(_mm256_cvtepi32_ps(p0), scale, bias));
+            _mm256_storeu_ps(out + i + 8, _mm256_fmadd_ps(_mm256_cvtepi32_ps(p1), scale, bias));
+            _mm256_storeu_ps(out + i + 16, _mm256_fmadd_ps(_mm256_cvtepi32_ps(p2), scale, bias));
+            _mm256_storeu_ps(out + i + 24, _mm256_fmadd_ps(_mm256_cvtepi32_ps(p3), scale, bias));
+        }
+    } else {
+        const int16_t *x = x_q;
+        for (; i + 16 <= count; i += 16) {
+            __m256i words = _mm256_loadu_si256((const __m256i *)(x + i));
+            __m256i p0 = _mm256_mullo_epi32(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(words)), w);
+            __m256i p1 = _mm256_mullo_epi32(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(words, 1)), w);
+            _mm256_storeu_ps(out + i, _mm256_fmadd_ps(_mm256_cvtepi32_ps(p0), scale, bias));
+            _mm256_storeu_ps(out + i + 8, _mm256_fmadd_ps(_mm256_cvtepi32_ps(p1), scale, bias));
+        }
+    }
+    return i;
+}
+#endif
+
+// Batched quantized inference: out[i] = prediction for x_q[i]
+void quant_predict_batch(const QuantModel *model, const void *x_q, float *out, size_t count) {
+    size_t done = 0;
+#ifdef QUANT_HAVE_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        done = quant_predict_avx2(model, x_q, out, count);
+    }
+#endif
+    quant_predict_scalar(model, x_q, out, done, count);
+}
+
+static double quant_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Float baseline for throughput: the forward block written out so it
+// vectorizes, kept out of line so the timing rounds can't be merged
+__attribute__((noinline))
+static void quant_float_batch(float w, float b, const float *x, float *out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = w * x[i] + b;
+    }
+}
+
+// Quantize one core or the ensemble of several, then report accuracy and
+// throughput against the float ai_block_forward path.
+int quant_report(OneCoreCtx *ctx, int bits, int *core_ids, int num_cores) {
+    // Large enough to stream from memory rather than cache
+    const size_t N = 1 << 24;
+    const int rounds = 5;
+
+    // Ensemble of linear models is the linear model with averaged parameters,
+    // read from each core's published snapshot (consistent mid-training)
+    float weight = 0.0f, bias = 0.0f;
+    int valid = 0;
+    for (int i = 0; i < num_cores; i++) {
+        CoreParams params;
+        if (snapshot_core(ctx, core_ids[i], &params) != 0) {
+            continue;
+        }
+        if (params.type == CORE_MLP) {
+            printf("Core %d is an MLP core; only linear cores can be quantized.\n", core_ids[i]);
+            continue;
+        }
+        if (params.trained) {
+            weight += params.weight;
+            bias += params.bias;
+            valid++;
+        }
+    }
+    if (valid == 0) {
+        printf("No trained cores to quantize.\n");
+        return -1;
+    }
+    weight /= valid;
+    bias /= valid;
+
+    float *x = malloc(N * sizeof(float));
+    float *ref = malloc(N * sizeof(float));
+    float *out = malloc(N * sizeof(float));
+    void *x_q = malloc(N * (bits == 8 ? 1 : 2));
+    if (!x || !ref || !out || !x_q) {
+        free(x); free(ref); free(out); free(x_q);
+        printf("Failed to allocate benchmark buffers.\n");
+        return -1;
+    }
+
+    // Same input range as the synthetic training data (0-10)
+    for (size_t i = 0; i < N; i++) {
+        x[i] = (float)(i % 1000) / 100.0f + (float)(i / 1000 % 100) / 10000.0f;
+    }
+
+    QuantModel model;
+    if (quant_model_init(&model, weight, bias, bits, x, N) != 0) {
+        free(x); free(ref); free(out); free(x_q);
+        printf("Quantization supports 8 or 16 bits.\n");
+        return -1;
+    }
+    quant_quantize_inputs(&model, x, x_q, N);
+
+    // Accuracy against the float path (and the ensemble block when several cores)
+    for (size_t i = 0; i < N; i++) {
+        ref[i] = ai_block_forward(weight, bias, x[i]);
+    }
+    quant_predict_batch(&model, x_q, out, N);
+    double max_err = 0.0, sum_err = 0.0, max_ref = 0.0;
+    for (size_t i = 0; i < N; i++) {
+        double err = fabs((double)out[i] - ref[i]);
+        if (err > max_err) max_err = err;
+        sum_err += err;
+        if (fabs(ref[i]) > max_ref) max_ref = fabs(ref[i]);
+    }
+    if (num_cores > 1) {
+        float e = ai_block_ensemble_predict(ctx, x[N / 2], core_ids, num_cores);
+        printf("Ensemble check at x=%.4f: ensemble=%.6f averaged=%.6f\n", x[N / 2], e, ref[N / 2]);
+    }
+
+    // Throughput
+    double t0 = quant_now();
+    for (int r = 0; r < rounds; r++) quant_float_batch(weight, bias, x, ref, N);
+    double t_float = quant_now() - t0;
+    t0 = quant_now();
+    for (int r = 0; r < rounds; r++) quant_predict_batch(&model, x_q, out, N);
+    double t_quant = quant_now() - t0;
+
+    double preds = (double)N * rounds;
+    printf("Quantized int%d model from %d core(s): w=%.6f -> %d x %.3e, b=%.6f, input scale %.3e\n",
+           bits, valid, weight, model.weight_q, model.weight_scale, bias, model.input_scale);
+    printf("  Accuracy vs float: max |err| %.6f, mean |err| %.6f (%.4f%% of max |y|)\n",
+           max_err, sum_err / N, max_ref > 0 ? 100.0 * max_err / max_ref : 0.0);
+    printf("  Float:     %.1f M predictions/s\n", preds / t_float / 1e6);
+    printf("  Quantized: %.1f M predictions/s (%.2fx), %s\n", preds / t_quant / 1e6, t_float / t_quant,
+#ifdef QUANT_HAVE_X86
+           __builtin_cpu_supports("avx2") ? "AVX2" : "scalar"
+#else
+           "scalar"
+#endif
+    );
+    printf("  Input storage: %d bytes/sample (float: %zu)\n", bits / 8, sizeof(float));
+
+    free(x);
+    free(ref);
+    free(out);
+    free(x_q);
+    return 0;
+}
@@ -0,0 +1,463 @@
+/*
+
+    OneCoreAI - Command Prompt
+
+    Interactive prompt and script runner on top of the engine library: one
+    OneCoreCtx per session, every command maps onto the library API.
+
+    At the prompt `train`, `run` and `resume` start background jobs and
+    return at once; a trailing `&` does the same in script mode.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "handle.h"
+#include "repl.h"
+#include "trace.h"
+
+// Training commands start background jobs ('jobs bg', the prompt's default)
+// instead of running to completion ('jobs fg', script mode's)
+static int background_default = 0;
+
+// Split a command line into whitespace-separated arguments (modifies line in place)
+int parse_command(char *line, char **argv, int max_args) {
+    int argc = 0;
+    char *save = NULL;
+
+    // Remove newline character
+    line[strcspn(line, "\r\n")] = 0;
+
+    for (char *tok = strtok_r(line, " \t", &save); tok && argc < max_args;
+         tok = strtok_r(NULL, " \t", &save)) {
+        argv[argc++] = tok;
+    }
+    return argc;
+}
+
+// Print the command reference
+void print_help() {
+    printf("\nAvailable Commands:\n");
+    printf("  create <name> <lr> <epochs>  - Create a new AI core\n");
+    printf("  run [&]                      - Train all cores (shows visualization in the foreground)\n");
+    printf("  status                       - Show status of all cores\n");
+    printf("  predict <core_id> <x>        - Make prediction with specific core\n");
+    printf("  delete <core_id>             - Delete a specific core\n");
+    printf("  size <core_id>               - Memory owned by a core and process RSS\n");
+    printf("  location <core_id>           - Block disk location\n");
+    printf("  clear                        - Clear all cores\n");
+    printf("  config <core_id> <lr> <epochs> - Configure a core\n");
+    printf("  train <core_id> [core_id2] ... [&] - Train specific cores ('&': as a background job)\n");
+    printf("  learn <core_id> <x> <y>      - Train specific core on single sample\n");
+    printf("  fetch <core_id>              - Extract variables from specific core\n");
+    printf("  setloss <core_id> <type>     - Set loss function (0=MSE, 1=MAE, 2=Huber)\n");
+    printf("  setreg <core_id> <lambda>    - Set L2 regularization coefficient\n");
+    printf("  stream <core_id> [on [forget]|off] - Streaming learner for 'learn' (exponential forgetting)\n");
+    printf("  stream <core_id> alert <loss> | feed <samples|file> - Drift alert level, or stream a dataset\n");
+    printf("  mlp <core_id> <h1[,h2..]> [relu|tanh] [batch] - Make a core a multi-layer perceptron\n");
+    printf("  mlp <core_id> off | mlp bench [size] - Back to linear, or time the GEMM kernel\n");
+    printf("  serve <socket> [workers] [port] - Serve predictions on a Unix socket (and localhost port)\n");
+    printf("  serve status|stop|wait       - Show server stats, stop it, or serve until SIGINT/SIGTERM\n");
+    printf("  publish </name>|stop         - Publish core parameters to POSIX shared memory\n");
+    printf("  checkpoint <epochs> [secs] [dir] - Checkpoint training in the background (0 disables a trigger)\n");
+    printf("  checkpoint off|status|flush  - Stop checkpointing, show stats, or wait for pending writes\n");
+    printf("  resume <core_id> <file> [&]  - Load a checkpoint and continue training at its epoch\n");
+    printf("  jobs [fg|bg]                 - List training jobs, or make training run in the foreground/background\n");
+    printf("  cancel <job_id>              - Stop a job at its next epoch\n");
+    printf("  wait <job_id>|all            - Wait for a job (or every job) to finish\n");
+    printf("  quant <8|16> <core_id> [...]  - Quantize a core (or ensemble) and compare with float\n");
+    printf("  precision fp32|fp16|bf16     - Storage precision of generated training data\n");
+    printf("  precision compare <core_id> [file|size] - Compare accuracy and epoch speed per precision\n");
+    printf("  arena                        - Show run arena mappings and peak usage\n");
+    printf("  metrics                      - Memory per core, datasets, arenas and process RSS\n");
+    printf("  gen [seed|slope|intercept|noise|threads <v>] - Show or configure the training data generator\n");
+    printf("  gen samples <n>              - Samples in the training set (default 1000)\n");
+    printf("  gen implicit on|off          - Compute training samples as they are read instead of storing them\n");
+    printf("  gen sheet <p>|<p0> ... <p7>  - Probability of each data sheet bit\n");
+    printf("  gen bench <samples> [threads] - Generator throughput and checksum\n");
+    printf("  numa [local|replicate|interleave] - Show topology or set parallel training data placement\n");
+    printf("  numa workers <n>             - Parallel training workers (0 = one per CPU)\n");
+    printf("  dp <core_id> <workers> [samples|file] [shm|unix|tcp] - Data-parallel training across processes\n");
+    printf("  aio                          - Show the async I/O backend and counters\n");
+    printf("  trace start | stop <file>    - Record training phases, write Chrome trace JSON\n");
+    printf("  hexlist                      - Display hex data from recent training\n");
+    printf("  info                         - Show system information\n");
+    printf("  help                         - Show this help message\n");
+    printf("  exit                         - Exit the program\n\n");
+}
+
+// Refuse to change a core a job is training (the prompt would block on its lock)
+static int core_idle(OneCoreCtx *ctx, int core_id) {
+    int job_id = job_core_busy(ctx, core_id);
+    if (job_id) {
+        printf("Core %d is being trained by job %d; wait for or cancel it first.\n", core_id, job_id);
+        return 0;
+    }
+    return 1;
+}
+
+// Lock an idle core for a settings change. A learn request or another
+// command may hold the lock for a moment; report busy rather than wait.
+// Returns 1 when the caller holds the lock.
+static int core_lock_settings(OneCoreCtx *ctx, int core_id) {
+    if (!core_idle(ctx, core_id)) {
+        return 0;
+    }
+    if (core_trylock(ctx, core_id) != 0) {
+        printf("Core %d is busy; try again when it is idle.\n", core_id);
+        return 0;
+    }
+    return 1;
+}
+
+// Run a training command as a job or to completion
+static int run_training(OneCoreCtx *ctx, int background, JobKind kind, int *core_ids, int count,
+                        const char *filename) {
+    if (background) {
+        int job_id = job_submit(ctx, kind, core_ids, count, filename);
+        if (job_id < 0) {
+            return -1;
+        }
+        printf("[job %d] started\n", job_id);
+        return 0;
+    }
+    switch (kind) {
+        case JOB_RUN:
+            return block_run(ctx);
+        case JOB_RESUME:
+            return resume_core(ctx, core_ids[0], filename);
+        default:
+            return train_cores(ctx, count, core_ids);
+    }
+}
+
+// Execute one parsed command. Returns 0 on success, -1 on error.
+int run_command(OneCoreCtx *ctx, int argc, char **argv) {
+    if (argc == 0) {
+        return 0;
+    }
+
+    const char *cmd = argv[0];
+    int background = background_default;
+    if (argc > 1 && strcmp(argv[argc - 1], "&") == 0) {
+        background = 1;
+        argc--;
+    }
+
+    if (strcmp(cmd, "help") == 0) {
+        print_help();
+    } else if (strcmp(cmd, "create") == 0 && argc >= 4) {
+        float lr = atof(argv[2]);
+        int epochs = atoi(argv[3]);
+        return core_create(ctx, argv[1], lr, epochs) < 0 ? -1 : 0;
+    } else if (strcmp(cmd, "run") == 0) {
+        return run_training(ctx, background, JOB_RUN, NULL, 0, NULL);
+    } else if (strcmp(cmd, "status") == 0) {
+        block_status(ctx);
+    } else if (strcmp(cmd, "predict") == 0 && argc >= 3) {
+        int core_id = atoi(argv[1]);
+        float x = atof(argv[2]);
+        AICore *core = core_get(ctx, core_id);
+        if (!core) {
+            printf("Invalid core ID: %d\n", core_id);
+            return -1;
+        }
+        float pred;
+        if (core->type == CORE_MLP) {
+            // MLP weights are only consistent between training steps
+            if (core_trylock(ctx, core_id) != 0) {
+                printf("Core %d is training; MLP predictions need it idle.\n", core_id);
+                return -1;
+            }
+            pred = ai_block_predict(core, x);
+            core_unlock(ctx, core_id);
+        } else {
+            // Linear cores answer from the last published epoch, even mid-training
+            CoreParams params;
+            snapshot_core(ctx, core_id, &params);
+            if (!params.trained) {
+                printf("Warning: Core %d not trained yet!\n", core_id);
+            }
+            pred = params.trained ? ai_block_forward(params.weight, params.bias, x) : 0.0f;
+        }
+        printf("Core %d prediction for x=%.2f: %.4f\n", core_id, x, pred);
+    } else if (strcmp(cmd, "delete") == 0 && argc >= 2) {
+        return core_delete(ctx, atoi(argv[1]));
+    } else if (strcmp(cmd, "clear") == 0) {
+        block_clear(ctx);
+    } else if (strcmp(cmd, "location") == 0 && argc >= 2) {
+        block_location(ctx, atoi(argv[1]));
+    } else if (strcmp(cmd, "size") == 0 && argc >= 2) {
+        return block_size(ctx, atoi(argv[1]));
+    } else if (strcmp(cmd, "config") == 0 && argc >= 4) {
+        int core_id = atoi(argv[1]);
+        AICore *core = core_get(ctx, core_id);
+        if (!core) {
+            printf("Invalid core ID: %d\n", core_id);
+            return -1;
+        }
+        if (!core_lock_settings(ctx, core_id)) {
+            return -1;
+        }
+        core->learning_rate = atof(argv[2]);
+        core->epochs = atoi(argv[3]);
+        snapshot_publish_core(ctx, core);
+        core_unlock(ctx, core_id);
+        printf("Reconfigured Core %d: lr=%.4f, epochs=%d\n", core_id, core->learning_rate, core->epochs);
+    } else if (strcmp(cmd, "train") == 0 && argc >= 2) {
+        int core_ids[MAX_CORES];
+        int count = 0;
+        for (int i = 1; i < argc && count < MAX_CORES; i++) {
+            core_ids[count++] = atoi(argv[i]);
+        }
+        return run_training(ctx, background, JOB_TRAIN, core_ids, count, NULL);
+    } else if (strcmp(cmd, "learn") == 0 && argc >= 4) {
+        if (!core_idle(ctx, atoi(argv[1]))) {
+            return -1;
+        }
+        return learn(ctx, atoi(argv[1]), atof(argv[2]), atof(argv[3]));
+    } else if (strcmp(cmd, "fetch") == 0 && argc >= 2) {
+        return fetch_data(ctx, atoi(argv[1]));
+    } else if (strcmp(cmd, "setloss") == 0 && argc >= 3) {
+        int core_id = atoi(argv[1]);
+        int loss_type = atoi(argv[2]);
+        AICore *core = core_get(ctx, core_id);
+        if (!core) {
+            printf("Invalid core ID: %d\n", core_id);
+            return -1;
+        }
+        if (loss_type < 0 || loss_type > 2) {
+            printf("Invalid loss type! Valid options: 0=MSE, 1=MAE, 2=Huber\n");
+            return -1;
+        }
+        if (!core_lock_settings(ctx, core_id)) {
+            return -1;
+        }
+        core->loss_type = (LossType)loss_type;
+        core_unlock(ctx, core_id);
+        const char *loss_names[] = {"MSE", "MAE", "Huber"};
+        printf("Core %d loss function set to: %s\n", core_id, loss_names[loss_type]);
+    } else if (strcmp(cmd, "setreg") == 0 && argc >= 3) {
+        int core_id = atoi(argv[1]);
+        float lambda = atof(argv[2]);
+        AICore *core = core_get(ctx, core_id);
+        if (!core) {
+            printf("Invalid core ID: %d\n", core_id);
+            return -1;
+        }
+        if (lambda < 0) {
+            printf("Regularization coefficient must be non-negative!\n");
+            return -1;
+        }
+        if (!core_lock_settings(ctx, core_id)) {
+            return -1;
+        }
+        core->regularization_lambda = lambda;
+        core_unlock(ctx, core_id);
+        printf("Core %d L2 regularization set to: %.6f\n", core_id, lambda);
+    } else if (strcmp(cmd, "stream") == 0 && argc >= 2) {
+        if (argc >= 3 && !core_idle(ctx, atoi(argv[1]))) {
+            return -1;
+        }
+        return stream_command(ctx, argc, argv);
+    } else if (strcmp(cmd, "mlp") == 0 && argc >= 2) {
+        // 'mlp bench <size>' names no core
+        if (argc >= 3 && strcmp(argv[1], "bench") != 0 && !core_idle(ctx, atoi(argv[1]))) {
+            return -1;
+        }
+        return mlp_command(ctx, argc, argv);
+    } else if (strcmp(cmd, "serve") == 0 && argc >= 2) {
+        if (strcmp(argv[1], "stop") == 0) {
+            return server_stop();
+        } else if (strcmp(argv[1], "wait") == 0) {
+            return server_wait();
+        } else if (strcmp(argv[1], "status") == 0) {
+            server_status();
+        } else {
+            int workers = argc >= 3 ? atoi(argv[2]) : 1;
+            int tcp_port = argc >= 4 ? atoi(argv[3]) : 0;
+            return server_start(ctx, argv[1], workers, tcp_port);
+        }
+    } else if (strcmp(cmd, "publish") == 0 && argc >= 2) {
+        if (strcmp(argv[1], "stop") == 0) {
+            return snapshot_unshare();
+        }
+        return snapshot_share(ctx, argv[1]);
+    } else if (strcmp(cmd, "checkpoint") == 0 && argc >= 2) {
+        if (strcmp(argv[1], "off") == 0) {
+            checkpoint_disable();
+        } else if (strcmp(argv[1], "status") == 0) {
+            checkpoint_status();
+        } else if (strcmp(argv[1], "flush") == 0) {
+            checkpoint_flush();
+        } else {
+            double seconds = argc >= 3 ? atof(argv[2]) : 0.0;
+            return checkpoint_enable(ctx, atoi(argv[1]), seconds, argc >= 4 ? argv[3] : ".");
+        }
+    } else if (strcmp(cmd, "resume") == 0 && argc >= 3) {
+        int core_id = atoi(argv[1]);
+        return run_training(ctx, background, JOB_RESUME, &core_id, 1, argv[2]);
+    } else if (strcmp(cmd, "jobs") == 0) {
+        if (argc >= 2 && (strcmp(argv[1], "fg") == 0 || strcmp(argv[1], "bg") == 0)) {
+            background_default = strcmp(argv[1], "bg") == 0;
+            printf("Training commands run in the %s.\n", background_default ? "background" : "foreground");
+        } else {
+            job_list(ctx);
+        }
+    } else if (strcmp(cmd, "cancel") == 0 && argc >= 2) {
+        return job_cancel(ctx, atoi(argv[1]));
+    } else if (strcmp(cmd, "wait") == 0 && argc >= 2) {
+        if (strcmp(argv[1], "all") == 0) {
+            return job_wait_all(ctx) > 0 ? -1 : 0;
+        }
+        return job_wait(ctx, atoi(argv[1]));
+    } else if (strcmp(cmd, "quant") == 0 && argc >= 3) {
+        int core_ids[MAX_CORES];
+        int count = 0;
+        for (int i = 2; i < argc && count < MAX_CORES; i++) {
+            core_ids[count++] = atoi(argv[i]);
+        }
+        return quant_report(ctx, atoi(argv[1]), core_ids, count);
+    } else if (strcmp(cmd, "precision") == 0 && argc >= 2) {
+        if (strcmp(argv[1], "compare") == 0 && argc >= 3) {
+            return dataset_compare_precision(ctx, atoi(argv[2]), argc >= 4 ? argv[3] : NULL);
+        }
+        DataPrecision precision;
+        if (dataset_parse_precision(argv[1], &precision) != 0) {
+            printf("Unknown precision: %s (fp32, fp16 or bf16)\n", argv[1]);
+            return -1;
+        }
+        onecore_set_precision(ctx, precision);
+        printf("Training data stored as %s\n", dataset_precision_name(precision));
+    } else if (strcmp(cmd, "gen") == 0) {
+        return generator_command(ctx, argc, argv);
+    } else if (strcmp(cmd, "numa") == 0) {
+        if (argc >= 3 && strcmp(argv[1], "workers") == 0) {
+            numa_set_workers(ctx, atoi(argv[2]));
+        } else if (argc >= 2) {
+            return numa_set_policy(ctx, argv[1]);
+        } else {
+            numa_report(ctx);
+        }
+    } else if (strcmp(cmd, "dp") == 0 && argc >= 3) {
+        if (!core_idle(ctx, atoi(argv[1]))) {
+            return -1;
+        }
+        return dist_train(ctx, atoi(argv[1]), atoi(argv[2]), argc >= 4 ? argv[3] : NULL, argc >= 5 ? argv[4] : NULL);
+    } else if (strcmp(cmd, "metrics") == 0) {
+        memory_report(ctx);
+    } else if (strcmp(cmd, "arena") == 0) {
+        arena_report();
+    } else if (strcmp(cmd, "aio") == 0) {
+        aio_report();
+    } else if (strcmp(cmd, "trace") == 0) {
+        if (argc >= 2 && strcmp(argv[1], "start") == 0) {
+            return trace_start();
+        } else if (argc >= 3 && strcmp(argv[1], "stop") == 0) {
+            return trace_stop(argv[2]);
+        } else if (argc >= 2) {
+            printf("Usage: trace [start|stop <file>]\n");
+            return -1;
+        }
+        trace_report();
+    } else if (strcmp(cmd, "hexlist") == 0) {
+        hex_list(ctx);
+    } else if (strcmp(cmd, "info") == 0) {
+        info();
+    } else {
+        printf("Unknown command or missing arguments: %s\n", cmd);
+        printf("Type 'help' for available commands.\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-f <file|->] [-j <jobs>] [-e]\n", prog);
+    fprintf(stderr, "  (no options)  Interactive command prompt\n");
+    fprintf(stderr, "  -f <file>     Run commands from file without prompts ('-' reads stdin)\n");
+    fprintf(stderr, "  -j <jobs>     Run independent commands on up to <jobs> threads\n");
+    fprintf(stderr, "  -e            Stop at the first failing command\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *script = NULL;
+    int jobs = 1;
+    int stop_on_error = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:j:eh")) != -1) {
+        switch (opt) {
+            case 'f':
+                script = optarg;
+                break;
+            case 'j':
+                jobs = atoi(optarg);
+                if (jobs < 1) jobs = 1;
+                break;
+            case 'e':
+                stop_on_error = 1;
+                break;
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    // One context for the session; the prediction server and shared-memory
+    // table serve its cores
+    OneCoreCtx *ctx = onecore_create();
+    if (!ctx) {
+        fprintf(stderr, "Failed to allocate the engine context\n");
+        return 2;
+    }
+    snapshot_attach(ctx);
+    trace_name_thread("main");
+
+    // Script mode: no prompts, no banner, exit code reflects failures
+    if (script) {
+        FILE *input = strcmp(script, "-") == 0 ? stdin : fopen(script, "r");
+        if (!input) {
+            perror(script);
+            return 2;
+        }
+        int failures = batch_run(ctx, input, jobs, stop_on_error);
+        if (input != stdin) fclose(input);
+
+        // Background jobs the script started finish before it exits
+        failures += job_wait_all(ctx);
+        return failures > 0 ? 1 : 0;
+    }
+
+    onecore_set_interactive(ctx, 1);
+    background_default = 1;
+
+    printf("Welcome to OneCoreAI - Multiple AI Core Blocks System\n");
+    printf("Type 'help' for available commands.\n\n");
+
+    char command[MAX_COMMAND_LINE];
+    char *args[MAX_COMMAND_ARGS];
+
+    while (1) {
+        printf("OneCoreAI> ");
+        fflush(stdout);
+
+        if (fgets(command, sizeof(command), stdin) == NULL) {
+            break;
+        }
+
+        int args_count = parse_command(command, args, MAX_COMMAND_ARGS);
+
+        if (args_count > 0 && (strcmp(args[0], "exit") == 0 || strcmp(args[0], "quit") == 0)) {
+            break;
+        }
+        run_command(ctx, args_count, args);
+        printf("\n");
+    }
+
+    job_shutdown(ctx);
+    printf("Goodbye!\n");
+    return 0;
+}
@@ -0,0 +1,28 @@
+/*
+
+    OneCoreAI - Command Interpreter
+
+    Shared by the interactive prompt (repl.c) and script mode (batch.c).
+    Both are part of the OneCoreAI program, not of the library, so this
+    header is private to them.
+
+*/
+
+#ifndef REPL_H
+#define REPL_H
+
+#include <stdio.h>
+#include "handle.h"
+
+#define MAX_COMMAND_LINE 4096
+#define MAX_COMMAND_ARGS 64
+
+// Command interpreter (repl.c)
+int parse_command(char *line, char **argv, int max_args);
+int run_command(OneCoreCtx *ctx, int argc, char **argv);
+void print_help();
+
+// Script mode: run commands from a file or stdin, returns number of failures (batch.c)
+int batch_run(OneCoreCtx *ctx, FILE *input, int jobs, int stop_on_error);
+
+#endif
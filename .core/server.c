@@ -0,0 +1,505 @@
+/*
+
+    OneCoreAI - Prediction Server
+
+    Serves predict, batch-predict, learn and fetch over a Unix domain socket
+    (and optionally localhost TCP) using the binary protocol in protocol.h.
+    Each worker thread runs its own epoll loop; the listening sockets are
+    shared with EPOLLEXCLUSIVE so new connections spread across workers.
+    Predictions read the published snapshot and never wait on training.
+
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "handle.h"
+#include "protocol.h"
+
+#define SERVER_MAX_WORKERS 64
+#define SERVER_BUFFER_SIZE (64 * 1024)
+#define SERVER_MAX_MESSAGE (sizeof(ServerRequest) + SERVER_MAX_VALUES * sizeof(float))
+
+typedef enum {
+    ENDPOINT_LISTEN,
+    ENDPOINT_STOP,
+    ENDPOINT_CONN
+} EndpointKind;
+
+// Anything registered with epoll starts with an endpoint
+typedef struct {
+    int fd;
+    EndpointKind kind;
+} ServerEndpoint;
+
+typedef struct ServerConn {
+    ServerEndpoint endpoint;
+    struct ServerConn *prev, *next;   // Worker's connection list
+    int want_write;                   // Waiting for EPOLLOUT
+    size_t in_len;
+    size_t out_len, out_off;
+    unsigned char in[SERVER_BUFFER_SIZE];
+    unsigned char out[SERVER_BUFFER_SIZE];
+} ServerConn;
+
+typedef struct {
+    pthread_t thread;
+    int epoll_fd;
+    ServerConn *conns;
+    _Alignas(64) atomic_ulong requests;
+    atomic_ulong connections;
+} ServerWorker;
+
+static struct {
+    int running;
+    OneCoreCtx *ctx;            // Context whose cores LEARN requests update
+    char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    int tcp_port;
+    ServerEndpoint unix_listen, tcp_listen, stop;
+    int worker_count;
+    ServerWorker workers[SERVER_MAX_WORKERS];
+} server = { .unix_listen = { -1, ENDPOINT_LISTEN }, .tcp_listen = { -1, ENDPOINT_LISTEN },
+             .stop = { -1, ENDPOINT_STOP } };
+
+// Execute one request, filling the response header and values. Returns value count.
+static uint16_t server_execute(const ServerRequest *req, const float *values,
+                               ServerResponse *resp, float *out) {
+    CoreParams params;
+
+    resp->op = req->op;
+    resp->tag = req->tag;
+    resp->status = SERVER_OK;
+
+    switch (req->op) {
+        case SERVER_OP_PREDICT:
+        case SERVER_OP_BATCH_PREDICT:
+            if ((req->op == SERVER_OP_PREDICT && req->count != 1) || req->count == 0) {
+                resp->status = SERVER_ERR_REQUEST;
+                return 0;
+            }
+            if (snapshot_read(req->core_id, &params) != 0) {
+                resp->status = SERVER_ERR_CORE;
+                return 0;
+            }
+            if (params.type != CORE_LINEAR) {
+                resp->status = SERVER_ERR_TYPE;
+                return 0;
+            }
+            if (!params.trained) {
+                resp->status = SERVER_ERR_UNTRAINED;
+                return 0;
+            }
+            for (uint16_t i = 0; i < req->count; i++) {
+                out[i] = ai_block_forward(params.weight, params.bias, values[i]);
+            }
+            return req->count;
+
+        case SERVER_OP_LEARN: {
+            if (req->count == 0 || req->count % 2 != 0) {
+                resp->status = SERVER_ERR_REQUEST;
+                return 0;
+            }
+            // Never park a worker behind a training run holding the core
+            OneCoreCtx *ctx = server.ctx;
+            if (req->core_id < 1 || req->core_id > MAX_CORES) {
+                resp->status = SERVER_ERR_CORE;
+                return 0;
+            }
+            if (core_trylock(ctx, req->core_id) != 0) {
+                resp->status = SERVER_ERR_BUSY;
+                return 0;
+            }
+            AICore *core = core_get(ctx, req->core_id);
+            if (!core || core->type != CORE_LINEAR) {
+                core_unlock(ctx, req->core_id);
+                resp->status = core ? SERVER_ERR_TYPE : SERVER_ERR_CORE;
+                return 0;
+            }
+            for (uint16_t i = 0; i < req->count; i += 2) {
+                ai_block_learn(core, values[i], values[i + 1]);
+            }
+            snapshot_publish_core(ctx, core);
+            out[0] = core->weight;
+            out[1] = core->bias;
+            core_unlock(ctx, req->core_id);
+            return 2;
+        }
+
+        case SERVER_OP_FETCH:
+            if (snapshot_read(req->core_id, &params) != 0) {
+                resp->status = SERVER_ERR_CORE;
+                return 0;
+            }
+            if (params.type != CORE_LINEAR) {
+                resp->status = SERVER_ERR_TYPE;
+                return 0;
+            }
+            out[0] = params.weight;
+            out[1] = params.bias;
+            out[2] = params.learning_rate;
+            out[3] = (float)params.epochs;
+            return 4;
+
+        default:
+            resp->status = SERVER_ERR_REQUEST;
+            return 0;
+    }
+}
+
+static void server_close(ServerWorker *worker, ServerConn *conn) {
+    epoll_ctl(worker->epoll_fd, EPOLL_CTL_DEL, conn->endpoint.fd, NULL);
+    close(conn->endpoint.fd);
+    if (conn->prev) conn->prev->next = conn->next;
+    else worker->conns = conn->next;
+    if (conn->next) conn->next->prev = conn->prev;
+    free(conn);
+}
+
+// Decode every complete request in the input buffer while output space remains.
+// Returns the number of requests handled, or -1 on a protocol violation.
+static int server_process(ServerWorker *worker, ServerConn *conn) {
+    size_t pos = 0;
+    unsigned long handled = 0;
+
+    while (conn->in_len - pos >= sizeof(ServerRequest)) {
+        ServerRequest req;
+        memcpy(&req, conn->in + pos, sizeof(req));
+        if (req.count > SERVER_MAX_VALUES) {
+            return -1;
+        }
+
+        size_t need = sizeof(req) + req.count * sizeof(float);
+        if (conn->in_len - pos < need) break;
+        if (SERVER_BUFFER_SIZE - conn->out_len < SERVER_MAX_MESSAGE) break;
+
+        float values[SERVER_MAX_VALUES];
+        float results[SERVER_MAX_VALUES];
+        ServerResponse resp;
+        memcpy(values, conn->in + pos + sizeof(req), req.count * sizeof(float));
+
+        resp.count = server_execute(&req, values, &resp, results);
+        memcpy(conn->out + conn->out_len, &resp, sizeof(resp));
+        memcpy(conn->out + conn->out_len + sizeof(resp), results, resp.count * sizeof(float));
+        conn->out_len += sizeof(resp) + resp.count * sizeof(float);
+
+        pos += need;
+        handled++;
+    }
+
+    if (pos > 0) {
+        memmove(conn->in, conn->in + pos, conn->in_len - pos);
+        conn->in_len -= pos;
+    }
+    atomic_fetch_add_explicit(&worker->requests, handled, memory_order_relaxed);
+    return (int)handled;
+}
+
+// Write pending output. Returns 1 if output remains, 0 if drained, -1 on error.
+static int server_flush(ServerConn *conn) {
+    while (conn->out_off < conn->out_len) {
+        ssize_t n = write(conn->endpoint.fd, conn->out + conn->out_off, conn->out_len - conn->out_off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 1;
+            return -1;
+        }
+        conn->out_off += n;
+    }
+    conn->out_len = conn->out_off = 0;
+    return 0;
+}
+
+// Handle readiness on a connection. Returns -1 if it should be closed.
+static int server_service(ServerWorker *worker, ServerConn *conn, uint32_t events) {
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        return -1;
+    }
+
+    if (events & EPOLLIN) {
+        while (conn->in_len < SERVER_BUFFER_SIZE) {
+            ssize_t n = read(conn->endpoint.fd, conn->in + conn->in_len, SERVER_BUFFER_SIZE - conn->in_len);
+            if (n == 0) return -1;
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return -1;
+            }
+            conn->in_len += n;
+        }
+    }
+
+    // Alternate processing and flushing until input is consumed or the socket is full
+    int handled, pending;
+    do {
+        handled = server_process(worker, conn);
+        if (handled < 0) return -1;
+        pending = server_flush(conn);
+        if (pending < 0) return -1;
+    } while (handled > 0 && !pending);
+
+    // Stop reading while the peer isn't draining responses
+    if (pending != conn->want_write) {
+        struct epoll_event ev = { .events = pending ? EPOLLOUT : EPOLLIN, .data.ptr = conn };
+        epoll_ctl(worker->epoll_fd, EPOLL_CTL_MOD, conn->endpoint.fd, &ev);
+        conn->want_write = pending;
+    }
+    return 0;
+}
+
+static void server_accept(ServerWorker *worker, int listen_fd) {
+    while (1) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+
+        if (listen_fd == server.tcp_listen.fd) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        ServerConn *conn = calloc(1, sizeof(ServerConn));
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        conn->endpoint.fd = fd;
+        conn->endpoint.kind = ENDPOINT_CONN;
+
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = conn };
+        if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            free(conn);
+            continue;
+        }
+        conn->next = worker->conns;
+        if (worker->conns) worker->conns->prev = conn;
+        worker->conns = conn;
+        atomic_fetch_add_explicit(&worker->connections, 1, memory_order_relaxed);
+    }
+}
+
+static void *server_worker(void *arg) {
+    ServerWorker *worker = arg;
+    struct epoll_event events[64];
+
+    while (1) {
+        int n = epoll_wait(worker->epoll_fd, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            ServerEndpoint *endpoint = events[i].data.ptr;
+            if (endpoint->kind == ENDPOINT_STOP) {
+                goto shutdown;
+            } else if (endpoint->kind == ENDPOINT_LISTEN) {
+                server_accept(worker, endpoint->fd);
+            } else if (server_service(worker, (ServerConn *)endpoint, events[i].events) != 0) {
+                server_close(worker, (ServerConn *)endpoint);
+            }
+        }
+    }
+
+shutdown:
+    while (worker->conns) {
+        server_close(worker, worker->conns);
+    }
+    return NULL;
+}
+
+static int server_listen_unix(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        printf("Socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int server_listen_tcp(int port) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        perror("tcp listen");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void server_close_listeners() {
+    if (server.unix_listen.fd >= 0) {
+        close(server.unix_listen.fd);
+        unlink(server.path);
+    }
+    if (server.tcp_listen.fd >= 0) close(server.tcp_listen.fd);
+    if (server.stop.fd >= 0) close(server.stop.fd);
+    server.unix_listen.fd = server.tcp_listen.fd = server.stop.fd = -1;
+}
+
+// Remove the socket file if the process exits while serving
+static void server_cleanup() {
+    if (server.running) {
+        unlink(server.path);
+    }
+}
+
+// Start serving the cores of ctx on a Unix socket (and localhost TCP if tcp_port > 0)
+int server_start(OneCoreCtx *ctx, const char *path, int workers, int tcp_port) {
+    if (server.running) {
+        printf("Server already running on %s\n", server.path);
+        return -1;
+    }
+    if (workers < 1) workers = 1;
+    if (workers > SERVER_MAX_WORKERS) workers = SERVER_MAX_WORKERS;
+
+    snprintf(server.path, sizeof(server.path), "%s", path);
+    server.tcp_port = tcp_port;
+    server.unix_listen.fd = server_listen_unix(path);
+    server.stop.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (tcp_port > 0) server.tcp_listen.fd = server_listen_tcp(tcp_port);
+    if (server.unix_listen.fd < 0 || server.stop.fd < 0 || (tcp_port > 0 && server.tcp_listen.fd < 0)) {
+        server_close_listeners();
+        return -1;
+    }
+
+    // Serve whatever is current, then keep workers from taking SIGINT/SIGTERM
+    server.ctx = ctx;
+    snapshot_attach(ctx);
+    sigset_t block, saved;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, &saved);
+
+    server.worker_count = 0;
+    for (int i = 0; i < workers; i++) {
+        ServerWorker *worker = &server.workers[i];
+        memset(worker, 0, sizeof(*worker));
+        worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLEXCLUSIVE, .data.ptr = &server.unix_listen };
+        epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, server.unix_listen.fd, &ev);
+        if (server.tcp_listen.fd >= 0) {
+            ev.data.ptr = &server.tcp_listen;
+            epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, server.tcp_listen.fd, &ev);
+        }
+        ev.events = EPOLLIN;
+        ev.data.ptr = &server.stop;
+        epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, server.stop.fd, &ev);
+
+        if (pthread_create(&worker->thread, NULL, server_worker, worker) != 0) {
+            close(worker->epoll_fd);
+            break;
+        }
+        server.worker_count++;
+    }
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+
+    if (server.worker_count == 0) {
+        server_close_listeners();
+        return -1;
+    }
+
+    static int cleanup_registered = 0;
+    if (!cleanup_registered) {
+        atexit(server_cleanup);
+        cleanup_registered = 1;
+    }
+
+    server.running = 1;
+    printf("Serving on %s", server.path);
+    if (tcp_port > 0) printf(" and 127.0.0.1:%d", tcp_port);
+    printf(" with %d worker(s)\n", server.worker_count);
+    return 0;
+}
+
+// Stop the server and close all connections
+int server_stop() {
+    if (!server.running) {
+        printf("Server is not running.\n");
+        return -1;
+    }
+
+    uint64_t one = 1;
+    if (write(server.stop.fd, &one, sizeof(one)) < 0) {
+        perror("server stop");
+    }
+    for (int i = 0; i < server.worker_count; i++) {
+        pthread_join(server.workers[i].thread, NULL);
+        close(server.workers[i].epoll_fd);
+    }
+    server_close_listeners();
+    server.running = 0;
+    printf("Server stopped.\n");
+    return 0;
+}
+
+// Block until SIGINT or SIGTERM, then stop the server
+int server_wait() {
+    if (!server.running) {
+        printf("Server is not running.\n");
+        return -1;
+    }
+
+    sigset_t set, saved;
+    int sig;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &set, &saved);
+    fflush(stdout);
+    sigwait(&set, &sig);
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+    return server_stop();
+}
+
+void server_status() {
+    if (!server.running) {
+        printf("Server is not running.\n");
+        return;
+    }
+
+    unsigned long requests = 0, connections = 0;
+    for (int i = 0; i < server.worker_count; i++) {
+        requests += atomic_load_explicit(&server.workers[i].requests, memory_order_relaxed);
+        connections += atomic_load_explicit(&server.workers[i].connections, memory_order_relaxed);
+    }
+    printf("Server: %s", server.path);
+    if (server.tcp_port > 0) printf(" and 127.0.0.1:%d", server.tcp_port);
+    printf("\n  Workers: %d\n  Connections accepted: %lu\n  Requests served: %lu\n",
+           server.worker_count, connections, requests);
+}
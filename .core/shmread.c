@@ -0,0 +1,60 @@
+/*
+
+    OneCoreAI - Shared Memory Reader
+
+    Example consumer of onecore_shm.h: prints the published parameters of
+    every core, optionally polling for changes.
+
+    Usage: onecoreai_shmread </name> [-w]
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "onecore_shm.h"
+
+static void print_table(const OneCoreShmTable *table) {
+    uint32_t count = onecore_shm_core_count(table);
+    printf("Generation %llu, %u core(s)\n", (unsigned long long)onecore_shm_generation(table), count);
+    for (uint32_t id = 1; id <= count; id++) {
+        float w, b;
+        int trained;
+        uint32_t version = onecore_shm_read(table, id, &w, &b, &trained);
+        if (version == 0) continue;
+        printf("  Core %u: w=%.4f, b=%.4f, trained=%s (version %u)\n",
+               id, w, b, trained ? "yes" : "no", version);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s </name> [-w]\n", argv[0]);
+        return 2;
+    }
+
+    const OneCoreShmTable *table = onecore_shm_open(argv[1]);
+    if (!table) {
+        fprintf(stderr, "No OneCoreAI table published at %s\n", argv[1]);
+        return 1;
+    }
+
+    print_table(table);
+
+    // Watch mode: spin on the generation counter (no syscalls per check)
+    if (argc >= 3 && strcmp(argv[2], "-w") == 0) {
+        uint64_t seen = onecore_shm_generation(table);
+        while (1) {
+            uint64_t now = onecore_shm_generation(table);
+            if (now != seen) {
+                seen = now;
+                print_table(table);
+                fflush(stdout);
+            }
+            usleep(1000);
+        }
+    }
+
+    onecore_shm_close(table);
+    return 0;
+}
@@ -0,0 +1,232 @@
+/*
+
+    OneCoreAI - Published Core Snapshots
+
+    Read-only copy of every core's learned parameters. Writers publish after
+    training, learning or reconfiguring a core; readers (the prediction
+    server, other processes via shared memory) never take a lock and never
+    wait on training.
+
+    Every context keeps its own copy of the entries, so reads of a core
+    that a background job is training (`predict`, `fetch`) see the last
+    completed epoch. The process table mirrors the cores of one attached
+    context; embedded contexts that do not serve never touch it.
+
+    The table lives in process memory until `publish <name>` moves it into a
+    POSIX shared-memory segment with the layout in onecore_shm.h.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include "handle.h"
+#include "context.h"
+#include "onecore_shm.h"
+
+_Static_assert(ONECORE_SHM_MAX_CORES == MAX_CORES, "shared table must hold every core");
+
+static OneCoreShmTable local_table = {
+    .magic = ONECORE_SHM_MAGIC, .layout = ONECORE_SHM_LAYOUT, .max_cores = ONECORE_SHM_MAX_CORES
+};
+static OneCoreShmTable *_Atomic snapshot_table = &local_table;
+static char shared_name[256];
+static OneCoreCtx *_Atomic snapshot_ctx;
+
+// Write one entry (the shared table never marks an MLP core trained:
+// its readers only know w * x + b). Writers race (a job's epoch loop against `serve`,
+// `publish` or `config` on the prompt), so each claims the entry by moving
+// seq from even to odd with a CAS and waits while another holds it.
+static void snapshot_write_entry(OneCoreShmEntry *entry, const AICore *core, int shared) {
+    uint32_t seq = atomic_load_explicit(&entry->seq, memory_order_relaxed);
+    for (;;) {
+        if (seq & 1) {
+            sched_yield();
+            seq = atomic_load_explicit(&entry->seq, memory_order_relaxed);
+        } else if (atomic_compare_exchange_weak_explicit(&entry->seq, &seq, seq + 1, memory_order_acquire,
+                                                         memory_order_relaxed)) {
+            break;
+        }
+    }
+    atomic_thread_fence(memory_order_release);
+
+    entry->weight = core->weight;
+    entry->bias = core->bias;
+    entry->learning_rate = core->learning_rate;
+    entry->epochs = core->epochs;
+    entry->trained = core->trained && (!shared || core->type == CORE_LINEAR);
+    entry->type = core->type;
+
+    atomic_store_explicit(&entry->seq, seq + 2, memory_order_release);
+}
+
+static void snapshot_write(OneCoreShmTable *table, OneCoreShmEntry *entry, const AICore *core) {
+    snapshot_write_entry(entry, core, 1);
+    atomic_fetch_add_explicit(&table->generation, 1, memory_order_release);
+}
+
+// Read a consistent copy of one entry
+static void snapshot_read_entry(const OneCoreShmEntry *entry, CoreParams *out) {
+    _Atomic uint32_t *seq = (_Atomic uint32_t *)&entry->seq;
+    uint32_t before, after;
+    do {
+        before = atomic_load_explicit(seq, memory_order_acquire);
+        out->weight = entry->weight;
+        out->bias = entry->bias;
+        out->learning_rate = entry->learning_rate;
+        out->epochs = entry->epochs;
+        out->trained = entry->trained;
+        out->type = entry->type;
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(seq, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+}
+
+// Publish the current parameters of one core (also a core just created
+// after the others, which extends the table without touching them)
+void snapshot_publish_core(OneCoreCtx *ctx, const AICore *core) {
+    if (core->id < 1 || core->id > MAX_CORES) {
+        return;
+    }
+    snapshot_write_entry(&ctx->published[core->id - 1], core, 0);
+    if (ctx != atomic_load_explicit(&snapshot_ctx, memory_order_acquire)) {
+        return;
+    }
+    OneCoreShmTable *table = atomic_load_explicit(&snapshot_table, memory_order_acquire);
+    snapshot_write(table, &table->entries[core->id - 1], core);
+    if ((int)atomic_load_explicit(&table->core_count, memory_order_relaxed) < core->id) {
+        atomic_store_explicit(&table->core_count, core->id, memory_order_release);
+    }
+}
+
+// Copy the cores of ctx (none if NULL) into a table
+static void snapshot_fill(OneCoreShmTable *table, OneCoreCtx *ctx) {
+    int count = ctx ? ctx->active_cores : 0;
+    for (int i = 0; i < count; i++) {
+        snapshot_write(table, &table->entries[i], &ctx->cores[i]);
+    }
+    atomic_store_explicit(&table->core_count, count, memory_order_release);
+}
+
+// Republish every core (after delete or clear renumbers them)
+void snapshot_publish_all(OneCoreCtx *ctx) {
+    for (int i = 0; i < ctx->active_cores; i++) {
+        snapshot_write_entry(&ctx->published[i], &ctx->cores[i], 0);
+    }
+    if (ctx == atomic_load_explicit(&snapshot_ctx, memory_order_acquire)) {
+        snapshot_fill(atomic_load_explicit(&snapshot_table, memory_order_acquire), ctx);
+    }
+}
+
+// Consistent copy of a core's parameters as of its last publish (the last
+// completed epoch while it trains). Returns 0, or -1 if the ID is invalid.
+int snapshot_core(OneCoreCtx *ctx, int core_id, CoreParams *out) {
+    if (core_id < 1 || core_id > ctx->active_cores) {
+        return -1;
+    }
+    snapshot_read_entry(&ctx->published[core_id - 1], out);
+    return 0;
+}
+
+// Make the table mirror ctx's cores
+void snapshot_attach(OneCoreCtx *ctx) {
+    atomic_store_explicit(&snapshot_ctx, ctx, memory_order_release);
+    snapshot_fill(atomic_load_explicit(&snapshot_table, memory_order_acquire), ctx);
+}
+
+// Empty the table if it mirrors ctx (the context is going away)
+void snapshot_detach(OneCoreCtx *ctx) {
+    OneCoreCtx *expected = ctx;
+    if (atomic_compare_exchange_strong(&snapshot_ctx, &expected, NULL)) {
+        snapshot_fill(atomic_load_explicit(&snapshot_table, memory_order_acquire), NULL);
+    }
+}
+
+// Read a consistent copy of a core's parameters. Returns 0, or -1 if the ID is invalid.
+int snapshot_read(int core_id, CoreParams *out) {
+    OneCoreShmTable *table = atomic_load_explicit(&snapshot_table, memory_order_acquire);
+    if (core_id < 1 || core_id > (int)atomic_load_explicit(&table->core_count, memory_order_acquire)) {
+        return -1;
+    }
+
+    snapshot_read_entry(&table->entries[core_id - 1], out);
+    return 0;
+}
+
+// Remove the shared segment name if the process exits while publishing
+static void snapshot_cleanup() {
+    if (shared_name[0]) {
+        shm_unlink(shared_name);
+    }
+}
+
+// Move the table into a POSIX shared-memory segment named `name`, mirroring ctx
+int snapshot_share(OneCoreCtx *ctx, const char *name) {
+    if (shared_name[0]) {
+        printf("Already publishing to %s\n", shared_name);
+        return -1;
+    }
+    if (name[0] != '/' || strlen(name) >= sizeof(shared_name) || strchr(name + 1, '/')) {
+        printf("Shared memory name must look like /name\n");
+        return -1;
+    }
+
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror(name);
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(OneCoreShmTable)) != 0) {
+        perror(name);
+        close(fd);
+        shm_unlink(name);
+        return -1;
+    }
+    void *map = mmap(NULL, sizeof(OneCoreShmTable), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror(name);
+        shm_unlink(name);
+        return -1;
+    }
+
+    // Fill the new table before readers (and the magic) can see it, then
+    // switch writers over and republish anything that raced the switch
+    OneCoreShmTable *table = map;
+    table->layout = ONECORE_SHM_LAYOUT;
+    table->max_cores = ONECORE_SHM_MAX_CORES;
+    snapshot_fill(table, ctx);
+    atomic_thread_fence(memory_order_release);
+    table->magic = ONECORE_SHM_MAGIC;
+    atomic_store_explicit(&snapshot_table, table, memory_order_release);
+    snapshot_attach(ctx);
+
+    static int cleanup_registered = 0;
+    if (!cleanup_registered) {
+        atexit(snapshot_cleanup);
+        cleanup_registered = 1;
+    }
+    strcpy(shared_name, name);
+    printf("Publishing core parameters to shared memory %s (%zu bytes)\n", name, sizeof(OneCoreShmTable));
+    return 0;
+}
+
+// Stop publishing: readers keep their mapping, the name is removed
+int snapshot_unshare() {
+    if (!shared_name[0]) {
+        printf("Not publishing to shared memory.\n");
+        return -1;
+    }
+
+    // The mapping is left in place so in-flight readers stay valid
+    OneCoreCtx *ctx = atomic_load_explicit(&snapshot_ctx, memory_order_acquire);
+    snapshot_fill(&local_table, ctx);
+    atomic_store_explicit(&snapshot_table, &local_table, memory_order_release);
+    snapshot_fill(&local_table, ctx);
+    shm_unlink(shared_name);
+    printf("Stopped publishing to %s\n", shared_name);
+    shared_name[0] = 0;
+    return 0;
+}
@@ -14,10 +14,6 @@
 #include <string.h>
 #include "handle.h"
 
-// External reference to cores (defined in init.c)
-extern AICore cores[];
-extern int active_cores;
-
 // Advanced AI Block Functions
 
 // Batch normalization block (simplified)
@@ -65,18 +61,9 @@ float ai_block_cross_validate(float (*predict_func)(float), float *x_test, float
     return total_error / test_size;
 }
 
-// Save core variables to file
-int ai_block_save_to_file(int core_id, const char *filename) {
-    if (core_id < 1 || core_id > active_cores) {
-        return -1;
-    }
-
-    FILE *file = fopen(filename, "w");
-    if (!file) {
-        return -1;
-    }
-
-    AICore *core = &cores[core_id - 1];
+// Write core variables in the text format read by ai_block_load_from_file.
+// A non-negative epoch is recorded so training can resume from it.
+int ai_block_write_variables(FILE *file, const AICore *core, int epoch) {
     fprintf(file, "Core Variables\n");
     fprintf(file, "ID: %d\n", core->id);
     fprintf(file, "Name: %s\n", core->name);
@@ -85,6 +72,12 @@ int ai_block_save_to_file(int core_id, const char *filename) {
     fprintf(file, "Learning_Rate: %.6f\n", core->learning_rate);
     fprintf(file, "Epochs: %d\n", core->epochs);
     fprintf(file, "Trained: %d\n", core->trained);
+    fprintf(file, "Loss_Type: %d\n", (int)core->loss_type);
+    fprintf(file, "Lambda: %.6f\n", core->regularization_lambda);
+    fprintf(file, "Huber_Delta: %.6f\n", core->huber_delta);
+    if (epoch >= 0) {
+        fprintf(file, "Checkpoint_Epoch: %d\n", epoch);
+    }
 
     // Save loss history
     fprintf(file, "Loss_History_Count: %d\n", core->loss_count);
@@ -92,13 +85,34 @@ int ai_block_save_to_file(int core_id, const char *filename) {
         fprintf(file, "Loss_%d: %.6f\n", i, core->loss_history[i]);
     }
 
-    fclose(file);
-    return 0;
+    return ferror(file) ? -1 : 0;
 }
 
-// Load core variables from file
-int ai_block_load_from_file(int core_id, const char *filename) {
-    if (core_id < 1 || core_id > active_cores) {
+// Save core variables to file
+int ai_block_save_to_file(OneCoreCtx *ctx, int core_id, const char *filename) {
+    AICore *core = core_get(ctx, core_id);
+    if (!core) {
+        return -1;
+    }
+
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        return -1;
+    }
+
+    int result = ai_block_write_variables(file, core, -1);
+    if (fclose(file) != 0) {
+        result = -1;
+    }
+    return result;
+}
+
+// Load core variables from a save or checkpoint file. If epoch is not NULL it
+// receives the checkpoint epoch (0 when the file has none). The files hold
+// linear parameters only, so MLP cores are refused.
+int ai_block_load_checkpoint(OneCoreCtx *ctx, int core_id, const char *filename, int *epoch) {
+    AICore *core = core_get(ctx, core_id);
+    if (!core || core->type != CORE_LINEAR) {
         return -1;
     }
 
@@ -107,13 +121,15 @@ int ai_block_load_from_file(int core_id, const char *filename) {
         return -1;
     }
 
-    AICore *core = &cores[core_id - 1];
     char line[256];
+    int loss_type, index;
+    float value;
 
-    while (fgets(line, sizeof(line), file)) {
-        char key[64];
-        float value;
+    if (epoch) {
+        *epoch = 0;
+    }
 
+    while (fgets(line, sizeof(line), file)) {
         if (sscanf(line, "Weight: %f", &value) == 1) {
             core->weight = value;
         } else if (sscanf(line, "Bias: %f", &value) == 1) {
@@ -124,24 +140,47 @@ int ai_block_load_from_file(int core_id, const char *filename) {
             // epochs is int
         } else if (sscanf(line, "Trained: %d", &core->trained) == 1) {
             // trained is int
+        } else if (sscanf(line, "Loss_Type: %d", &loss_type) == 1) {
+            if (loss_type >= LOSS_MSE && loss_type <= LOSS_HUBER) {
+                core->loss_type = (LossType)loss_type;
+            }
+        } else if (sscanf(line, "Lambda: %f", &value) == 1) {
+            core->regularization_lambda = value;
+        } else if (sscanf(line, "Huber_Delta: %f", &value) == 1) {
+            core->huber_delta = value;
+        } else if (epoch && sscanf(line, "Checkpoint_Epoch: %d", epoch) == 1) {
+            // resume point
+        } else if (sscanf(line, "Loss_History_Count: %d", &core->loss_count) == 1) {
+            if (core->loss_count < 0) core->loss_count = 0;
+            if (core->loss_count > 100) core->loss_count = 100;
+        } else if (sscanf(line, "Loss_%d: %f", &index, &value) == 2) {
+            if (index >= 0 && index < 100) {
+                core->loss_history[index] = value;
+            }
         }
     }
 
     fclose(file);
+    stream_restart(core);
+    snapshot_publish_core(ctx, core);
     return 0;
 }
 
+// Load core variables from file
+int ai_block_load_from_file(OneCoreCtx *ctx, int core_id, const char *filename) {
+    return ai_block_load_checkpoint(ctx, core_id, filename, NULL);
+}
+
 // Ensemble prediction block (average predictions from multiple cores)
-float ai_block_ensemble_predict(float x, int *core_ids, int num_cores) {
+float ai_block_ensemble_predict(OneCoreCtx *ctx, float x, int *core_ids, int num_cores) {
     if (num_cores == 0) return 0.0f;
 
     float total_pred = 0.0f;
     int valid_cores = 0;
 
     for (int i = 0; i < num_cores; i++) {
-        int core_id = core_ids[i];
-        if (core_id >= 1 && core_id <= active_cores) {
-            AICore *core = &cores[core_id - 1];
+        AICore *core = core_get(ctx, core_ids[i]);
+        if (core) {
             if (core->trained) {
                 total_pred += core->weight * x + core->bias;
                 valid_cores++;
@@ -153,14 +192,9 @@ float ai_block_ensemble_predict(float x, int *core_ids, int num_cores) {
 }
 
 // Calculate loss statistics across training history
-void ai_block_loss_statistics(int core_id, float *min_loss, float *max_loss, float *avg_loss) {
-    if (core_id < 1 || core_id > active_cores) {
-        *min_loss = *max_loss = *avg_loss = 0.0f;
-        return;
-    }
-
-    AICore *core = &cores[core_id - 1];
-    if (core->loss_count == 0) {
+void ai_block_loss_statistics(OneCoreCtx *ctx, int core_id, float *min_loss, float *max_loss, float *avg_loss) {
+    AICore *core = core_get(ctx, core_id);
+    if (!core || core->loss_count == 0) {
         *min_loss = *max_loss = *avg_loss = 0.0f;
         return;
     }
@@ -180,13 +214,9 @@ void ai_block_loss_statistics(int core_id, float *min_loss, float *max_loss, flo
 }
 
 // Detect loss convergence
-int ai_block_loss_converged(int core_id, float tolerance) {
-    if (core_id < 1 || core_id > active_cores) {
-        return 0;
-    }
-
-    AICore *core = &cores[core_id - 1];
-    if (core->loss_count < 10) {  // Need minimum history
+int ai_block_loss_converged(OneCoreCtx *ctx, int core_id, float tolerance) {
+    AICore *core = core_get(ctx, core_id);
+    if (!core || core->loss_count < 10) {  // Need minimum history
         return 0;
     }
 
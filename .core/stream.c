@@ -0,0 +1,312 @@
+/*
+
+    OneCoreAI - Streaming Learner
+
+    With streaming on, `learn` (and the server's learn requests) no longer
+    take one SGD step per sample. The core keeps exponentially weighted
+    sums of 1, x, y, x^2 and xy: each new sample is added with weight 1
+    after every older one is multiplied by the forgetting factor, so a
+    sample k steps back counts forget^k and the effective window is about
+    1 / (1 - forget) samples. After each sample the parameters are the
+    minimizer of the windowed loss plus the core's L2 term, a 2x2 solve of
+
+        (A + n * lambda * I) [w b] = c
+
+    For MSE this is recursive least squares with forgetting. MAE and Huber
+    weight each sample by psi(e) / e of its residual before the update
+    (iteratively reweighted least squares carried along the stream), so
+    outliers pull the fit no harder than their gradient would.
+
+    Every sample's loss is measured before the core learns from it and
+    decayed the same way; the window loss is their weighted mean, and
+    crossing the alert level counts as a drift alert.
+
+    Memory and time per sample are O(1) and the solution is exact, so no
+    learning rate or gradient clipping is involved.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "handle.h"
+
+#define STREAM_DEFAULT_FORGET 0.999f
+
+// Weight of the parameters the stream starts from, about one sample
+#define STREAM_PRIOR 1.0
+
+// Samples before drift alerts are raised
+#define STREAM_WARMUP 32
+
+// MAE weights are 1/|e|; residuals below this count as this
+#define STREAM_MAE_FLOOR 1e-3
+
+// Below this det / (a11 * a22) the x values in the window do not pin down w
+#define STREAM_SINGULAR 1e-12
+
+// Start a fresh window from the core's current parameters
+int stream_enable(AICore *core, float forget) {
+    if (core->type != CORE_LINEAR) {
+        printf("Core %d is an MLP core; streaming learns linear cores.\n", core->id);
+        return -1;
+    }
+    if (!(forget > 0.0f && forget <= 1.0f)) {
+        printf("Forgetting factor must be in (0, 1].\n");
+        return -1;
+    }
+    float alert = core->stream.alert;
+    memset(&core->stream, 0, sizeof(core->stream));
+    core->stream.enabled = 1;
+    core->stream.forget = forget;
+    core->stream.alert = alert;
+    core->stream.prior = STREAM_PRIOR;
+    core->stream.prior_w = core->weight;
+    core->stream.prior_b = core->bias;
+    return 0;
+}
+
+// Parameters set by something other than the stream (train, resume, load,
+// dp) void the window's sums: start a fresh one from them, same forgetting
+void stream_restart(AICore *core) {
+    if (core->stream.enabled && core->type == CORE_LINEAR) {
+        stream_enable(core, core->stream.forget);
+    }
+}
+
+void stream_disable(AICore *core) {
+    core->stream.enabled = 0;
+}
+
+// Sample loss and IRLS weight psi(e) / e of residual e (MSE: 2 for loss e^2)
+static inline __attribute__((always_inline))
+double stream_weight(LossType loss_type, double e, double delta, double *loss) {
+    double abs_e = fabs(e);
+    switch (loss_type) {
+        case LOSS_MAE:
+            *loss = abs_e;
+            return 1.0 / (abs_e > STREAM_MAE_FLOOR ? abs_e : STREAM_MAE_FLOOR);
+        case LOSS_HUBER:
+            if (abs_e <= delta) {
+                *loss = 0.5 * e * e;
+                return 1.0;
+            }
+            *loss = delta * (abs_e - 0.5 * delta);
+            return delta / abs_e;
+        default:
+            *loss = e * e;
+            return 2.0;
+    }
+}
+
+// The per-sample loop, inlined once per loss type so the switch folds away
+static inline __attribute__((always_inline))
+void stream_run(StreamState *s, double *w_out, double *b_out, const float *xs, const float *ys,
+                size_t count, LossType loss_type, double delta, double lambda) {
+    const double f = s->forget;
+    double w = *w_out, b = *b_out;
+    double n = s->n, sw = s->sw, sx = s->sx, sy = s->sy, sxx = s->sxx, sxy = s->sxy;
+    double prior = s->prior, window_loss = s->loss;
+    const double pw = s->prior_w, pb = s->prior_b;
+    const double alert = s->alert;
+    const uint64_t warm = s->samples < STREAM_WARMUP ? STREAM_WARMUP - s->samples : 0;
+    int drifting = s->drifting;
+    uint64_t alerts = s->alerts;
+
+    for (size_t i = 0; i < count; i++) {
+        const double x = xs[i], y = ys[i];
+        double loss;
+        double omega = stream_weight(loss_type, w * x + b - y, delta, &loss);
+
+        n = f * n + 1.0;
+        sw = f * sw + omega;
+        sx = f * sx + omega * x;
+        sy = f * sy + omega * y;
+        sxx = f * sxx + omega * x * x;
+        sxy = f * sxy + omega * x * y;
+        prior *= f;
+        window_loss = f * window_loss + loss;
+
+        double ridge = lambda * n + prior;
+        double a11 = sxx + ridge, a22 = sw + ridge;
+        double c1 = sxy + prior * pw, c2 = sy + prior * pb;
+        double det = a11 * a22 - sx * sx;
+        if (det > STREAM_SINGULAR * a11 * a22) {
+            double inv = 1.0 / det;
+            w = (c1 * a22 - sx * c2) * inv;
+            b = (a11 * c2 - sx * c1) * inv;
+        } else if (a22 > 0.0) {
+            // Every x in the window is the same: keep w, refit b
+            b = (c2 - sx * w) / a22;
+        }
+
+        if (alert > 0.0 && i + 1 >= warm) {
+            int above = window_loss > alert * n;
+            alerts += above && !drifting;
+            drifting = above;
+        }
+    }
+
+    s->n = n;
+    s->sw = sw;
+    s->sx = sx;
+    s->sy = sy;
+    s->sxx = sxx;
+    s->sxy = sxy;
+    s->prior = prior;
+    s->loss = window_loss;
+    s->samples += count;
+    s->drifting = drifting;
+    s->alerts = alerts;
+    *w_out = w;
+    *b_out = b;
+}
+
+// Learn a run of samples in order (caller holds the core lock)
+void stream_learn_batch(AICore *core, const float *x, const float *y, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    StreamState *s = &core->stream;
+    double w = core->weight, b = core->bias;
+    const double delta = core->huber_delta, lambda = core->regularization_lambda;
+
+    switch (core->loss_type) {
+        case LOSS_MAE:
+            stream_run(s, &w, &b, x, y, count, LOSS_MAE, delta, lambda);
+            break;
+        case LOSS_HUBER:
+            stream_run(s, &w, &b, x, y, count, LOSS_HUBER, delta, lambda);
+            break;
+        default:
+            stream_run(s, &w, &b, x, y, count, LOSS_MSE, delta, lambda);
+            break;
+    }
+
+    // A degenerate window (all-zero weights, overflow) leaves the parameters alone
+    if (isfinite(w) && isfinite(b)) {
+        core->weight = (float)w;
+        core->bias = (float)b;
+    }
+    core->trained = 1;
+}
+
+void stream_learn(AICore *core, float x, float y) {
+    stream_learn_batch(core, &x, &y, 1);
+}
+
+// Weighted mean loss of the samples in the window, each taken before learning from it
+float stream_window_loss(const AICore *core) {
+    const StreamState *s = &core->stream;
+    return s->n > 0.0 ? (float)(s->loss / s->n) : 0.0f;
+}
+
+void stream_describe(const AICore *core) {
+    const StreamState *s = &core->stream;
+    if (!s->enabled) {
+        printf("  Streaming: off\n");
+        return;
+    }
+    printf("  Streaming: forget %.6f", s->forget);
+    if (s->forget < 1.0f) printf(" (window ~%.0f samples)", 1.0 / (1.0 - s->forget));
+    else printf(" (no forgetting)");
+    printf(", %llu samples, window loss %.6f\n", (unsigned long long)s->samples, stream_window_loss(core));
+    if (s->alert > 0.0f) {
+        printf("  Drift alert above %.6f: %llu alert(s)%s\n", s->alert, (unsigned long long)s->alerts,
+               s->drifting ? ", DRIFTING" : "");
+    }
+}
+
+static double stream_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Stream a dataset file or `samples` generated samples through the core, in order
+// (computed as they are read with 'gen implicit on', so any count fits in memory)
+static int stream_feed(OneCoreCtx *ctx, AICore *core, const char *source) {
+    Dataset data;
+    char *end = NULL;
+    size_t samples = strtoull(source, &end, 10);
+    int from_file = end == source || *end != '\0';
+    const GeneratorConfig *config = onecore_generator(ctx);
+    if (!from_file && config->implicit) {
+        generator_implicit(&data, config, 0, samples);
+    } else if (from_file ? dataset_load_file(&data, source, PRECISION_FP32) != 0
+                         : dataset_alloc(&data, samples, PRECISION_FP32) != 0) {
+        printf("Failed to %s dataset %s\n", from_file ? "load" : "generate", source);
+        return -1;
+    } else if (!from_file) {
+        generator_fill(&data, config);
+    }
+
+    core_lock(ctx, core->id);
+    uint64_t alerts = core->stream.alerts;
+    double start = stream_now();
+    for (size_t i = 0; i < data.size; i += DATASET_CHUNK) {
+        DatasetChunk chunk;
+        size_t count = dataset_chunk(&data, i, DATASET_CHUNK, &chunk);
+        stream_learn_batch(core, chunk.x, chunk.y, count);
+    }
+    double seconds = stream_now() - start;
+    snapshot_publish_core(ctx, core);
+
+    printf("Streamed %zu %s samples into Core %d in %.3f s (%.1f M samples/s)\n", data.size,
+           from_file ? "loaded" : "generated", core->id, seconds,
+           seconds > 0 ? data.size / seconds / 1e6 : 0.0);
+    printf("  w=%.4f, b=%.4f, window loss %.6f", core->weight, core->bias, stream_window_loss(core));
+    if (core->stream.alert > 0.0f) {
+        printf(", %llu new drift alert(s)", (unsigned long long)(core->stream.alerts - alerts));
+    }
+    printf("\n");
+    core_unlock(ctx, core->id);
+    dataset_free(&data);
+    return 0;
+}
+
+// 'stream' command: stream <core_id> [on [forget]|off|alert <loss>|feed <samples|file>]
+int stream_command(OneCoreCtx *ctx, int argc, char **argv) {
+    int core_id = atoi(argv[1]);
+    AICore *core = core_get(ctx, core_id);
+    if (!core) {
+        printf("Invalid core ID: %d\n", core_id);
+        return -1;
+    }
+    if (argc < 3) {
+        printf("Core %d (%s):\n", core->id, core->name);
+        stream_describe(core);
+        return 0;
+    }
+
+    const char *what = argv[2];
+    if (strcmp(what, "feed") == 0 && argc >= 4) {
+        if (!core->stream.enabled) {
+            printf("Streaming is off for Core %d ('stream %d on' first).\n", core_id, core_id);
+            return -1;
+        }
+        return stream_feed(ctx, core, argv[3]);
+    }
+
+    int result = 0;
+    core_lock(ctx, core_id);
+    if (strcmp(what, "on") == 0) {
+        result = stream_enable(core, argc >= 4 ? atof(argv[3]) : STREAM_DEFAULT_FORGET);
+    } else if (strcmp(what, "off") == 0) {
+        stream_disable(core);
+    } else if (strcmp(what, "alert") == 0 && argc >= 4) {
+        core->stream.alert = atof(argv[3]) > 0 ? atof(argv[3]) : 0.0f;
+        core->stream.drifting = 0;
+    } else {
+        printf("Usage: stream <core_id> [on [forget]|off|alert <loss>|feed <samples|file>]\n");
+        result = -1;
+    }
+    if (result == 0) {
+        printf("Core %d (%s):\n", core->id, core->name);
+        stream_describe(core);
+    }
+    core_unlock(ctx, core_id);
+    return result;
+}
@@ -0,0 +1,449 @@
+/*
+
+    OneCoreAI - Event Tracing
+
+    Each thread records into its own buffer: a chain of fixed-size blocks
+    it alone appends to, publishing the record count with a release store.
+    Buffers are registered once per thread under a lock and stay
+    registered; a new `trace start` begins a new session, and an owner
+    that sees the session change rewinds its buffer before the next
+    record. Buffers of exited threads are kept until the session they
+    recorded in has been written out.
+
+    Forked data-parallel workers record into their own copy of this state
+    and hand their records back through a shared mapping (TraceShare).
+
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "handle.h"
+#include "trace.h"
+
+// Records per block, and at most per thread and session (24 bytes each)
+#define TRACE_BLOCK (16 * 1024)
+#define TRACE_MAX_RECORDS (2 * 1024 * 1024)
+
+typedef struct {
+    uint64_t ns;                // CLOCK_MONOTONIC
+    int64_t value;
+    int32_t core;               // -1: not about one core
+    uint8_t kind;
+    char phase;                 // 'B' or 'E'
+} TraceRecord;
+
+typedef struct TraceBlock {
+    struct TraceBlock *_Atomic next;
+    TraceRecord records[TRACE_BLOCK];
+} TraceBlock;
+
+typedef struct TraceBuffer {
+    struct TraceBuffer *next;   // Registry (under trace.lock)
+    _Atomic unsigned session;   // Session the records belong to
+    _Atomic size_t count;       // Records written, published with release
+    _Atomic int retired;        // Owner thread exited (or imported from a child)
+    size_t dropped;
+    TraceBlock *first;
+    TraceBlock *current;        // Block receiving record `count`
+    int pid;
+    int tid;
+    char name[32];
+} TraceBuffer;
+
+// One forked worker's slot in a TraceShare; its records follow the slots
+typedef struct {
+    int pid;
+    size_t count;
+    size_t dropped;
+    char name[32];
+} TraceShareSlot;
+
+struct TraceShare {
+    size_t bytes;
+    int ranks;
+    size_t capacity;
+    TraceShareSlot slots[];
+};
+
+static const struct {
+    const char *name;
+    const char *category;
+    const char *arg;            // Label of the value argument, or NULL
+} trace_kinds[TRACE_KIND_COUNT] = {
+    [TRACE_GENERATE] = { "generate", "data", "samples" },
+    [TRACE_SHEET_STATS] = { "sheet stats", "data", "samples" },
+    [TRACE_EPOCH] = { "epoch", "train", "epoch" },
+    [TRACE_GRADIENTS] = { "gradients", "train", "epoch" },
+    [TRACE_REDUCE] = { "all-reduce", "train", "epoch" },
+    [TRACE_UPDATE] = { "update", "train", "epoch" },
+    [TRACE_VISUALIZE] = { "visualize", "display", "epoch" },
+    [TRACE_CHECKPOINT] = { "checkpoint write", "io", "files" },
+};
+
+_Atomic int trace_on;
+
+static struct {
+    pthread_mutex_t lock;       // Registry, start and stop
+    TraceBuffer *buffers;
+    _Atomic unsigned session;
+    uint64_t started_ns;
+    TraceShare *child_share;    // In a forked worker: where its records go
+    int child_rank;
+} trace = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static _Thread_local TraceBuffer *trace_local;
+static _Thread_local char trace_thread_label[32];
+static pthread_key_t trace_key;
+static pthread_once_t trace_key_once = PTHREAD_ONCE_INIT;
+
+static uint64_t trace_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Thread exit: keep the records until they are written out
+static void trace_thread_exit(void *arg) {
+    TraceBuffer *buf = arg;
+    atomic_store(&buf->retired, 1);
+}
+
+static void trace_make_key() {
+    pthread_key_create(&trace_key, trace_thread_exit);
+}
+
+static void trace_free_buffer(TraceBuffer *buf) {
+    TraceBlock *block = buf->first;
+    while (block) {
+        TraceBlock *next = atomic_load(&block->next);
+        free(block);
+        block = next;
+    }
+    free(buf);
+}
+
+// Drop buffers of exited threads (caller holds trace.lock)
+static void trace_free_retired() {
+    TraceBuffer **link = &trace.buffers;
+    while (*link) {
+        TraceBuffer *buf = *link;
+        if (atomic_load(&buf->retired)) {
+            *link = buf->next;
+            trace_free_buffer(buf);
+        } else {
+            link = &buf->next;
+        }
+    }
+}
+
+// Start recording into the current session (owner thread only)
+static void trace_rewind(TraceBuffer *buf, unsigned session) {
+    atomic_store_explicit(&buf->count, 0, memory_order_relaxed);
+    buf->dropped = 0;
+    buf->current = buf->first;
+    atomic_store_explicit(&buf->session, session, memory_order_release);
+}
+
+static TraceBuffer *trace_new_buffer(int pid, int tid, const char *name) {
+    TraceBuffer *buf = calloc(1, sizeof(TraceBuffer));
+    if (!buf) {
+        return NULL;
+    }
+    buf->first = malloc(sizeof(TraceBlock));
+    if (!buf->first) {
+        free(buf);
+        return NULL;
+    }
+    atomic_store(&buf->first->next, NULL);
+    buf->pid = pid;
+    buf->tid = tid;
+    snprintf(buf->name, sizeof(buf->name), "%s", name);
+    return buf;
+}
+
+// Slow path of the first record in a session
+static TraceBuffer *trace_attach(unsigned session) {
+    TraceBuffer *buf = trace_local;
+    if (!buf) {
+        pthread_once(&trace_key_once, trace_make_key);
+        int tid = (int)syscall(SYS_gettid);
+        char name[32];
+        if (trace_thread_label[0]) snprintf(name, sizeof(name), "%s", trace_thread_label);
+        else snprintf(name, sizeof(name), "thread %d", tid);
+        buf = trace_new_buffer(getpid(), tid, name);
+        if (!buf) {
+            return NULL;
+        }
+        pthread_mutex_lock(&trace.lock);
+        buf->next = trace.buffers;
+        trace.buffers = buf;
+        pthread_mutex_unlock(&trace.lock);
+        pthread_setspecific(trace_key, buf);
+        trace_local = buf;
+    }
+    trace_rewind(buf, session);
+    return buf;
+}
+
+// Append one record (owner thread only)
+static void trace_append(TraceBuffer *buf, const TraceRecord *record) {
+    size_t n = atomic_load_explicit(&buf->count, memory_order_relaxed);
+    if (n >= TRACE_MAX_RECORDS) {
+        buf->dropped++;
+        return;
+    }
+    size_t slot = n % TRACE_BLOCK;
+    if (slot == 0 && n > 0) {
+        TraceBlock *next = atomic_load_explicit(&buf->current->next, memory_order_relaxed);
+        if (!next) {
+            next = malloc(sizeof(TraceBlock));
+            if (!next) {
+                buf->dropped++;
+                return;
+            }
+            atomic_store_explicit(&next->next, NULL, memory_order_relaxed);
+            atomic_store_explicit(&buf->current->next, next, memory_order_release);
+        }
+        buf->current = next;
+    }
+    buf->current->records[slot] = *record;
+    atomic_store_explicit(&buf->count, n + 1, memory_order_release);
+}
+
+void trace_record(TraceKind kind, char phase, int core, int64_t value) {
+    unsigned session = atomic_load_explicit(&trace.session, memory_order_relaxed);
+    TraceBuffer *buf = trace_local;
+    if (!buf || atomic_load_explicit(&buf->session, memory_order_relaxed) != session) {
+        buf = trace_attach(session);
+        if (!buf) return;
+    }
+    TraceRecord record = {
+        .ns = trace_now_ns(), .value = value, .core = core, .kind = (uint8_t)kind, .phase = phase
+    };
+    trace_append(buf, &record);
+}
+
+void trace_name_thread(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(trace_thread_label, sizeof(trace_thread_label), format, args);
+    va_end(args);
+}
+
+int trace_start() {
+    pthread_mutex_lock(&trace.lock);
+    if (atomic_load(&trace_on)) {
+        pthread_mutex_unlock(&trace.lock);
+        printf("Tracing is already on.\n");
+        return -1;
+    }
+    trace_free_retired();
+    trace.started_ns = trace_now_ns();
+    atomic_fetch_add(&trace.session, 1);
+    atomic_store(&trace_on, 1);
+    pthread_mutex_unlock(&trace.lock);
+    printf("Tracing started.\n");
+    return 0;
+}
+
+static void trace_write_record(FILE *file, const TraceBuffer *buf, const TraceRecord *r, uint64_t origin,
+                               int *first) {
+    double us = r->ns >= origin ? (r->ns - origin) / 1000.0 : 0.0;
+    int kind = r->kind < TRACE_KIND_COUNT ? r->kind : TRACE_EPOCH;
+    fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d",
+            *first ? "" : ",", trace_kinds[kind].name, trace_kinds[kind].category, r->phase, us,
+            buf->pid, buf->tid);
+    *first = 0;
+    if (r->phase == 'B') {
+        fprintf(file, ",\"args\":{");
+        if (r->core >= 0) fprintf(file, "\"core\":%d%s", r->core, trace_kinds[kind].arg ? "," : "");
+        if (trace_kinds[kind].arg) fprintf(file, "\"%s\":%lld", trace_kinds[kind].arg, (long long)r->value);
+        fprintf(file, "}");
+    }
+    fprintf(file, "}");
+}
+
+// Stop recording and write the session as Chrome trace JSON
+int trace_stop(const char *filename) {
+    pthread_mutex_lock(&trace.lock);
+    if (!atomic_load(&trace_on)) {
+        pthread_mutex_unlock(&trace.lock);
+        printf("Tracing is not on.\n");
+        return -1;
+    }
+    atomic_store(&trace_on, 0);
+    unsigned session = atomic_load(&trace.session);
+
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        trace_free_retired();
+        pthread_mutex_unlock(&trace.lock);
+        printf("Failed to open %s; trace discarded.\n", filename);
+        return -1;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+
+    size_t events = 0, dropped = 0;
+    int threads = 0, first = 1;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (TraceBuffer *buf = trace.buffers; buf; buf = buf->next) {
+        if (atomic_load_explicit(&buf->session, memory_order_acquire) != session) {
+            continue;
+        }
+        size_t count = atomic_load_explicit(&buf->count, memory_order_acquire);
+        if (count == 0) {
+            continue;
+        }
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",", buf->pid, buf->tid, buf->name);
+        first = 0;
+
+        TraceBlock *block = buf->first;
+        for (size_t i = 0; i < count && block; i++) {
+            if (i > 0 && i % TRACE_BLOCK == 0) {
+                block = atomic_load_explicit(&block->next, memory_order_acquire);
+                if (!block) break;
+            }
+            trace_write_record(file, buf, &block->records[i % TRACE_BLOCK], trace.started_ns, &first);
+        }
+        events += count;
+        dropped += buf->dropped;
+        threads++;
+    }
+    fprintf(file, "\n]}\n");
+    int failed = ferror(file) | (fclose(file) != 0);
+
+    trace_free_retired();
+    pthread_mutex_unlock(&trace.lock);
+
+    if (failed) {
+        printf("Failed to write %s\n", filename);
+        return -1;
+    }
+    printf("Wrote %zu events from %d thread(s) to %s", events, threads, filename);
+    if (dropped > 0) printf(" (%zu dropped: buffers full)", dropped);
+    printf("\n");
+    return 0;
+}
+
+void trace_report() {
+    pthread_mutex_lock(&trace.lock);
+    unsigned session = atomic_load(&trace.session);
+    size_t events = 0, dropped = 0;
+    int threads = 0;
+    for (TraceBuffer *buf = trace.buffers; buf; buf = buf->next) {
+        if (atomic_load_explicit(&buf->session, memory_order_acquire) != session) continue;
+        events += atomic_load_explicit(&buf->count, memory_order_acquire);
+        dropped += buf->dropped;
+        threads++;
+    }
+    int on = atomic_load(&trace_on);
+    double seconds = on ? (trace_now_ns() - trace.started_ns) / 1e9 : 0.0;
+    pthread_mutex_unlock(&trace.lock);
+
+    if (!on) {
+        printf("Tracing: off\n");
+        return;
+    }
+    printf("Tracing: on for %.1f s, %zu events from %d thread(s)", seconds, events, threads);
+    if (dropped > 0) printf(", %zu dropped", dropped);
+    printf("\n");
+}
+
+// Map a share for `ranks` forked workers, or NULL when tracing is off
+TraceShare *trace_share_create(int ranks, size_t records_per_rank) {
+    if (!atomic_load(&trace_on) || ranks < 1) {
+        return NULL;
+    }
+    if (records_per_rank > TRACE_MAX_RECORDS) records_per_rank = TRACE_MAX_RECORDS;
+    size_t header = sizeof(TraceShare) + ranks * sizeof(TraceShareSlot);
+    header = (header + sizeof(TraceRecord) - 1) / sizeof(TraceRecord) * sizeof(TraceRecord);
+    size_t bytes = header + (size_t)ranks * records_per_rank * sizeof(TraceRecord);
+    TraceShare *share = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (share == MAP_FAILED) {
+        return NULL;
+    }
+    share->bytes = bytes;
+    share->ranks = ranks;
+    share->capacity = records_per_rank;
+    return share;
+}
+
+static TraceRecord *trace_share_records(TraceShare *share, int rank) {
+    size_t header = sizeof(TraceShare) + share->ranks * sizeof(TraceShareSlot);
+    header = (header + sizeof(TraceRecord) - 1) / sizeof(TraceRecord) * sizeof(TraceRecord);
+    return (TraceRecord *)((char *)share + header) + (size_t)rank * share->capacity;
+}
+
+// In a freshly forked worker: forget the parent's buffers (they belong to
+// its threads) and record this process's events for the share
+void trace_child(TraceShare *share, int rank) {
+    pthread_mutex_init(&trace.lock, NULL);
+    trace.buffers = NULL;
+    trace_local = NULL;
+    trace.child_share = share;
+    trace.child_rank = rank;
+    if (!share) {
+        atomic_store(&trace_on, 0);
+    }
+}
+
+// Copy this worker's records into its slot before it exits
+void trace_child_exit() {
+    TraceShare *share = trace.child_share;
+    if (!share) {
+        return;
+    }
+    TraceShareSlot *slot = &share->slots[trace.child_rank];
+    TraceRecord *out = trace_share_records(share, trace.child_rank);
+    unsigned session = atomic_load(&trace.session);
+    slot->pid = getpid();
+    snprintf(slot->name, sizeof(slot->name), "%s", trace_thread_label[0] ? trace_thread_label : "worker");
+
+    for (TraceBuffer *buf = trace.buffers; buf; buf = buf->next) {
+        if (atomic_load(&buf->session) != session) continue;
+        size_t count = atomic_load(&buf->count);
+        TraceBlock *block = buf->first;
+        for (size_t i = 0; i < count && block; i++) {
+            if (i > 0 && i % TRACE_BLOCK == 0) block = atomic_load(&block->next);
+            if (!block) break;
+            if (slot->count < share->capacity) out[slot->count++] = block->records[i % TRACE_BLOCK];
+            else slot->dropped++;
+        }
+        slot->dropped += buf->dropped;
+    }
+}
+
+// After the workers exit: add their records to this session and unmap the share
+void trace_share_collect(TraceShare *share) {
+    if (!share) {
+        return;
+    }
+    pthread_mutex_lock(&trace.lock);
+    unsigned session = atomic_load(&trace.session);
+    for (int rank = 0; rank < share->ranks && atomic_load(&trace_on); rank++) {
+        TraceShareSlot *slot = &share->slots[rank];
+        if (slot->count == 0) continue;
+        TraceBuffer *buf = trace_new_buffer(slot->pid, slot->pid, slot->name);
+        if (!buf) continue;
+        trace_rewind(buf, session);
+        const TraceRecord *records = trace_share_records(share, rank);
+        for (size_t i = 0; i < slot->count; i++) {
+            trace_append(buf, &records[i]);
+        }
+        buf->dropped += slot->dropped;
+        atomic_store(&buf->retired, 1);
+        buf->next = trace.buffers;
+        trace.buffers = buf;
+    }
+    pthread_mutex_unlock(&trace.lock);
+    munmap(share, share->bytes);
+}
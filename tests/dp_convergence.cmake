@@ -0,0 +1,80 @@
+# Data-parallel training must converge to what `train` reaches on the same
+# data: one core is trained in-process, three more with `dp` over the shm,
+# unix and tcp all-reduce, and the fetched w and b are compared.
+#
+#   cmake -DONECORE=<OneCoreAI> -DWORK_DIR=<dir> -P dp_convergence.cmake
+
+if(NOT ONECORE OR NOT WORK_DIR)
+    message(FATAL_ERROR "usage: cmake -DONECORE=<OneCoreAI> -DWORK_DIR=<dir> -P dp_convergence.cmake")
+endif()
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+# fetch prints 4 decimals; compare in units of 1e-4 (summation order may
+# move the last digit)
+set(TOLERANCE 2)
+
+function(fixed4 value out)
+    string(REPLACE "." "" digits "${value}")
+    string(REGEX REPLACE "^(-?)0+([0-9])" "\\1\\2" digits "${digits}")
+    set(${out} "${digits}" PARENT_SCOPE)
+endfunction()
+
+function(check_close what a b)
+    fixed4("${a}" ia)
+    fixed4("${b}" ib)
+    math(EXPR diff "${ia} - ${ib}")
+    if(diff LESS 0)
+        math(EXPR diff "-(${diff})")
+    endif()
+    if(diff GREATER ${TOLERANCE})
+        message(FATAL_ERROR "${what}: ${a} vs ${b}")
+    endif()
+endfunction()
+
+# Run one scenario; `setup` is prepended to the script (generator settings)
+function(run_case name setup samples epochs)
+    set(script "${WORK_DIR}/dp_${name}.txt")
+    file(WRITE "${script}" "${setup}gen samples ${samples}
+create single 0.002 ${epochs}
+create shm 0.002 ${epochs}
+create unix 0.002 ${epochs}
+create tcp 0.002 ${epochs}
+train 1
+dp 2 3 ${samples} shm
+dp 3 3 ${samples} unix
+dp 4 2 ${samples} tcp
+fetch 1
+fetch 2
+fetch 3
+fetch 4
+")
+    execute_process(COMMAND "${ONECORE}" -f "${script}" INPUT_FILE /dev/null
+                    OUTPUT_VARIABLE output ERROR_VARIABLE output RESULT_VARIABLE result TIMEOUT 120)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${name}: OneCoreAI exited with ${result}\n${output}")
+    endif()
+
+    foreach(id 1 2 3 4)
+        if(NOT output MATCHES "Core ${id} Variables: w=(-?[0-9]+\\.[0-9]+), b=(-?[0-9]+\\.[0-9]+)")
+            message(FATAL_ERROR "${name}: no parameters for core ${id}\n${output}")
+        endif()
+        set(w${id} "${CMAKE_MATCH_1}")
+        set(b${id} "${CMAKE_MATCH_2}")
+    endforeach()
+    foreach(id 2 3 4)
+        check_close("${name}: w of dp core ${id} vs train" "${w${id}}" "${w1}")
+        check_close("${name}: b of dp core ${id} vs train" "${b${id}}" "${b1}")
+    endforeach()
+    message(STATUS "${name}: train and dp (shm, unix, tcp) agree on w=${w1}, b=${b1}")
+    set(w "${w1}" PARENT_SCOPE)
+endfunction()
+
+# Plain y = 2x + 1 + noise: training has to get w close to 2
+run_case(plain "gen sheet 0\n" 4000 300)
+fixed4("${w}" iw)
+if(iw LESS 18000 OR iw GREATER 22000)
+    message(FATAL_ERROR "plain: w=${w} did not converge towards 2")
+endif()
+
+# Default data sheets (gradient scaling, swaps and zeroing per sample)
+run_case(sheets "" 4000 200)
@@ -0,0 +1,134 @@
+/*
+
+    OneCoreAI - Grouped MSE Epoch Check
+
+    An MSE epoch computed from per-sheet sufficient statistics must equal
+    the per-sample epoch loop on the same data: checked at several (w, b)
+    points on sheet-heavy data, with and without L2, and over whole
+    training runs stepped through each path.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "handle.h"
+
+#define SAMPLES 20000
+#define TRAIN_EPOCHS 100
+
+static int failures = 0;
+
+// Per-sample sums are fp32 over SAMPLES terms, the grouped ones fp64
+static void check_close(const char *what, double per_sample, double grouped, double scale) {
+    double tolerance = 1e-4 * (scale > 1.0 ? scale : 1.0);
+    if (!(fabs(per_sample - grouped) <= tolerance)) {
+        printf("FAIL %s: per-sample %.9g, grouped %.9g\n", what, per_sample, grouped);
+        failures++;
+    }
+}
+
+static void check_epoch(const char *name, const Dataset *data, const SheetStats *stats, float lambda,
+                        float w, float b) {
+    AICore core;
+    memset(&core, 0, sizeof(core));
+    core.type = CORE_LINEAR;
+    core.loss_type = LOSS_MSE;
+    core.regularization_lambda = lambda;
+    core.weight = w;
+    core.bias = b;
+
+    EpochSums per_sample, grouped;
+    ai_block_select_kernel(&core, data)(&core, data, &per_sample);
+    ai_block_epoch_grouped(&core, stats, &grouped);
+
+    // Gradient sums cancel near the optimum, so their rounding follows the
+    // size of the terms: sum |e x| <= sqrt(sum e^2 * sum x^2) (Cauchy-Schwarz),
+    // and sheet rules scale a term by at most 3
+    double n = 0.0, sxx = 0.0;
+    for (int g = 0; g < stats->used_count; g++) {
+        n += stats->n[stats->used[g]];
+        sxx += stats->xx[stats->used[g]];
+    }
+    double loss = fabs(per_sample.loss);
+    char what[128];
+    snprintf(what, sizeof(what), "%s lambda=%g w=%g b=%g loss", name, lambda, w, b);
+    check_close(what, per_sample.loss, grouped.loss, loss);
+    snprintf(what, sizeof(what), "%s lambda=%g w=%g b=%g dw", name, lambda, w, b);
+    check_close(what, per_sample.dw, grouped.dw, 6.0 * sqrt(loss * sxx));
+    snprintf(what, sizeof(what), "%s lambda=%g w=%g b=%g db", name, lambda, w, b);
+    check_close(what, per_sample.db, grouped.db, 6.0 * sqrt(loss * n));
+    if (per_sample.count != grouped.count) {
+        printf("FAIL %s: counts %zu vs %zu\n", name, per_sample.count, grouped.count);
+        failures++;
+    }
+}
+
+// Train one core per path with the same steps and compare the parameters
+static void check_training(const char *name, const Dataset *data, const SheetStats *stats, float lambda) {
+    AICore a, g;
+    memset(&a, 0, sizeof(a));
+    a.type = CORE_LINEAR;
+    a.loss_type = LOSS_MSE;
+    a.regularization_lambda = lambda;
+    a.learning_rate = 0.002f;
+    g = a;
+
+    EpochKernel kernel = ai_block_select_kernel(&a, data);
+    for (int epoch = 0; epoch < TRAIN_EPOCHS; epoch++) {
+        EpochSums sums;
+        kernel(&a, data, &sums);
+        ai_block_step(&a, &sums);
+        ai_block_epoch_grouped(&g, stats, &sums);
+        ai_block_step(&g, &sums);
+    }
+
+    char what[128];
+    snprintf(what, sizeof(what), "%s lambda=%g trained w", name, lambda);
+    check_close(what, a.weight, g.weight, 1.0);
+    snprintf(what, sizeof(what), "%s lambda=%g trained b", name, lambda);
+    check_close(what, a.bias, g.bias, 1.0);
+}
+
+static int run_case(const char *name, float sheet_prob) {
+    GeneratorConfig config;
+    generator_defaults(&config);
+    for (int bit = 0; bit < 8; bit++) {
+        config.sheet_prob[bit] = sheet_prob;
+    }
+
+    Dataset data;
+    if (dataset_alloc(&data, SAMPLES, PRECISION_FP32) != 0) {
+        printf("FAIL %s: cannot allocate %d samples\n", name, SAMPLES);
+        return -1;
+    }
+    generator_fill(&data, &config);
+
+    static SheetStats stats;
+    ai_block_sheet_stats(&data, &stats);
+
+    const float lambdas[] = { 0.0f, 0.05f };
+    const float points[][2] = { { 0.0f, 0.0f }, { 2.0f, 1.0f }, { -1.5f, 0.25f }, { 0.3f, -4.0f } };
+    for (size_t l = 0; l < sizeof(lambdas) / sizeof(lambdas[0]); l++) {
+        for (size_t p = 0; p < sizeof(points) / sizeof(points[0]); p++) {
+            check_epoch(name, &data, &stats, lambdas[l], points[p][0], points[p][1]);
+        }
+        check_training(name, &data, &stats, lambdas[l]);
+    }
+    printf("%s: %d sheet value(s) used\n", name, stats.used_count);
+    dataset_free(&data);
+    return 0;
+}
+
+int main() {
+    if (run_case("no sheets", 0.0f) != 0 || run_case("sheets p=0.5", 0.5f) != 0 ||
+        run_case("sheets p=0.9", 0.9f) != 0) {
+        return 1;
+    }
+    if (failures) {
+        printf("%d mismatch(es)\n", failures);
+        return 1;
+    }
+    printf("Grouped MSE epochs match the per-sample loops.\n");
+    return 0;
+}
@@ -0,0 +1,176 @@
+/*
+
+    OneCoreAI - Half-Precision Dataset Check
+
+    fp16 and bf16 columns written with dataset_set and read back through
+    dataset_chunk (F16C/AVX2 where the CPU has them, scalar code for the
+    tails) must give back every finite half value exactly, and round any
+    other fp32 value to the nearest one, ties to even. The expected
+    results come from a table of all 2^16 half values, not from the
+    conversion code under test.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "handle.h"
+
+// Not a multiple of 8 or of DATASET_CHUNK, so vector loops and scalar tails both run
+#define RANDOM_SAMPLES 100003
+
+static int failures = 0;
+
+static uint32_t bits_of(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static float float_of(uint32_t u) {
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// Value of an fp16 bit pattern, computed arithmetically
+static float fp16_value(uint16_t h) {
+    int exp = (h >> 10) & 0x1F, mant = h & 0x3FF;
+    float v = exp == 0 ? ldexpf((float)mant, -24) : ldexpf(1.0f + mant / 1024.0f, exp - 15);
+    return (h & 0x8000) ? -v : v;
+}
+
+static float bf16_value(uint16_t h) {
+    return float_of((uint32_t)h << 16);
+}
+
+// Finite non-negative half values in ascending order (their bit patterns ascend too)
+typedef struct {
+    float value[0x8000];
+    int count;
+} HalfTable;
+
+static void table_build(HalfTable *table, DataPrecision precision) {
+    uint16_t last = precision == PRECISION_FP16 ? 0x7BFF : 0x7F7F;
+    table->count = last + 1;
+    for (int h = 0; h <= last; h++) {
+        table->value[h] = precision == PRECISION_FP16 ? fp16_value((uint16_t)h) : bf16_value((uint16_t)h);
+    }
+}
+
+// Nearest table value to v, ties to the even bit pattern (|v| within range)
+static float table_round(const HalfTable *table, float v) {
+    float a = fabsf(v);
+    int lo = 0, hi = table->count - 1;
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (table->value[mid] <= a) lo = mid;
+        else hi = mid;
+    }
+    double below = (double)a - table->value[lo], above = (double)table->value[hi] - a;
+    int pick = a >= table->value[hi] ? hi : below < above ? lo : above < below ? hi : (lo & 1 ? hi : lo);
+    return v < 0.0f || (v == 0.0f && signbit(v)) ? -table->value[pick] : table->value[pick];
+}
+
+// Store x (and -x as y) at `precision`, read back and compare with expected
+static void check_round_trip(const char *name, DataPrecision precision, const float *x, const float *expected,
+                             size_t count) {
+    float *y = malloc(count * sizeof(float));
+    Dataset data;
+    if (!y || dataset_alloc(&data, count, precision) != 0) {
+        printf("FAIL %s: cannot allocate %zu samples\n", name, count);
+        failures++;
+        free(y);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) y[i] = -x[i];
+    dataset_set(&data, 0, x, y, NULL, count);
+
+    int reported = 0;
+    for (size_t start = 0; start < count; start += DATASET_CHUNK) {
+        DatasetChunk chunk;
+        size_t n = dataset_chunk(&data, start, DATASET_CHUNK, &chunk);
+        for (size_t i = 0; i < n; i++) {
+            float want = expected[start + i];
+            if (bits_of(chunk.x[i]) != bits_of(want) || bits_of(chunk.y[i]) != bits_of(-want)) {
+                if (reported++ < 5) {
+                    printf("FAIL %s: %.9g -> x %.9g, y %.9g, expected %.9g\n", name, x[start + i],
+                           chunk.x[i], chunk.y[i], want);
+                }
+                failures++;
+            }
+        }
+    }
+    dataset_free(&data);
+    free(y);
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+
+static uint64_t rng_next() {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void check_precision(const char *name, DataPrecision precision) {
+    static HalfTable table;
+    table_build(&table, precision);
+
+    // Every finite half value, both signs, comes back unchanged
+    size_t count = 2 * (size_t)table.count;
+    float *x = malloc(count * sizeof(float));
+    float *expected = malloc(count * sizeof(float));
+    for (int h = 0; h < table.count; h++) {
+        x[2 * h] = expected[2 * h] = table.value[h];
+        x[2 * h + 1] = expected[2 * h + 1] = -table.value[h];
+    }
+    char what[64];
+    snprintf(what, sizeof(what), "%s exact", name);
+    check_round_trip(what, precision, x, expected, count);
+    free(x);
+    free(expected);
+
+    // Random fp32 values across the half range, midpoints between neighbours
+    // (ties) and points just either side of them
+    float top = table.value[table.count - 1];
+    int min_exp = precision == PRECISION_FP16 ? -26 : -135;
+    int max_exp = precision == PRECISION_FP16 ? 16 : 127;
+    x = malloc(RANDOM_SAMPLES * sizeof(float));
+    expected = malloc(RANDOM_SAMPLES * sizeof(float));
+    for (size_t i = 0; i < RANDOM_SAMPLES; i++) {
+        float v;
+        uint64_t r = rng_next();
+        if (i % 3 == 0) {
+            int h = (int)(r % (uint64_t)(table.count - 1));
+            double mid = ((double)table.value[h] + table.value[h + 1]) / 2.0;
+            v = (float)mid;
+            if (i % 9 == 3) v = nextafterf(v, 0.0f);
+            if (i % 9 == 6) v = nextafterf(v, INFINITY);
+        } else {
+            float mant = 1.0f + (float)(r >> 40) / 16777216.0f;
+            v = ldexpf(mant, min_exp + (int)((r >> 8) % (uint64_t)(max_exp - min_exp)));
+        }
+        if (v > top) v = top;
+        if (r & 1) v = -v;
+        x[i] = v;
+        expected[i] = table_round(&table, v);
+    }
+    snprintf(what, sizeof(what), "%s rounding", name);
+    check_round_trip(what, precision, x, expected, RANDOM_SAMPLES);
+    free(x);
+    free(expected);
+}
+
+int main() {
+    check_precision("fp16", PRECISION_FP16);
+    check_precision("bf16", PRECISION_BF16);
+    if (failures) {
+        printf("%d mismatch(es)\n", failures);
+        return 1;
+    }
+    printf("fp16 and bf16 columns round-trip and round to nearest even.\n");
+    return 0;
+}
@@ -0,0 +1,215 @@
+/*
+
+    OneCoreAI - Implicit Dataset Check
+
+    An implicit dataset (columns computed from the sample index as they are
+    read) must read back bit for bit what a stored fill of the same range
+    holds, also through views and clones, and train to the same epoch sums.
+    A random x column must not repeat any sample's y noise, and constant
+    sheet columns clamp to a byte.
+
+    Stored fills are generated through the implicit columns, so the samples
+    are also pinned to the `gen bench` checksum the stored generator gave
+    before implicit columns existed.
+
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "handle.h"
+
+#define SAMPLES 300001
+
+// `gen bench 5000000` with the default settings (seed 42)
+#define GOLDEN_SAMPLES 5000000
+#define GOLDEN_CHECKSUM 0x7e1f0fda6321a1a9ull
+
+static int failures = 0;
+
+static int same_bits(const void *a, const void *b, size_t bytes) {
+    return memcmp(a, b, bytes) == 0;
+}
+
+// Read both datasets chunk by chunk and compare every value's bits
+static void compare_reads(const char *name, const Dataset *implicit, const Dataset *stored) {
+    if (implicit->size != stored->size) {
+        printf("FAIL %s: sizes %zu vs %zu\n", name, implicit->size, stored->size);
+        failures++;
+        return;
+    }
+    for (size_t start = 0; start < stored->size; start += DATASET_CHUNK) {
+        DatasetChunk a, b;
+        size_t n = dataset_chunk(implicit, start, DATASET_CHUNK, &a);
+        if (n != dataset_chunk(stored, start, DATASET_CHUNK, &b) ||
+            !same_bits(a.x, b.x, n * sizeof(float)) || !same_bits(a.y, b.y, n * sizeof(float)) ||
+            !same_bits(a.data_sheet, b.data_sheet, n)) {
+            printf("FAIL %s: samples from %zu differ\n", name, start);
+            failures++;
+            return;
+        }
+    }
+}
+
+// Epoch sums over each dataset, with and without L2
+static void compare_training(const char *name, const Dataset *implicit, const Dataset *stored) {
+    for (int reg = 0; reg < 2; reg++) {
+        for (int loss = LOSS_MSE; loss <= LOSS_HUBER; loss++) {
+            AICore core;
+            memset(&core, 0, sizeof(core));
+            core.type = CORE_LINEAR;
+            core.loss_type = (LossType)loss;
+            core.regularization_lambda = reg ? 0.05f : 0.0f;
+            core.huber_delta = 1.0f;
+            core.weight = 1.5f;
+            core.bias = -0.5f;
+
+            EpochSums a, b;
+            ai_block_select_kernel(&core, implicit)(&core, implicit, &a);
+            ai_block_select_kernel(&core, stored)(&core, stored, &b);
+            if (!same_bits(&a.loss, &b.loss, sizeof(float)) || !same_bits(&a.dw, &b.dw, sizeof(float)) ||
+                !same_bits(&a.db, &b.db, sizeof(float)) || a.count != b.count) {
+                printf("FAIL %s: loss type %d, lambda %g: epoch sums differ\n", name, loss,
+                       core.regularization_lambda);
+                failures++;
+            }
+        }
+    }
+
+    static SheetStats a, b;
+    ai_block_sheet_stats(implicit, &a);
+    ai_block_sheet_stats(stored, &b);
+    if (!same_bits(&a, &b, sizeof(a))) {
+        printf("FAIL %s: per-sheet statistics differ\n", name);
+        failures++;
+    }
+}
+
+static void check_config(const char *name, const GeneratorConfig *config, uint64_t first) {
+    Dataset implicit, stored;
+    generator_implicit(&implicit, config, first, SAMPLES);
+    if (!dataset_is_implicit(&implicit) || dataset_bytes(&implicit) != 0) {
+        printf("FAIL %s: implicit dataset holds storage\n", name);
+        failures++;
+    }
+    if (dataset_alloc(&stored, SAMPLES, PRECISION_FP32) != 0) {
+        printf("FAIL %s: cannot allocate %d samples\n", name, SAMPLES);
+        failures++;
+        return;
+    }
+    generator_fill_from(&stored, config, first);
+
+    compare_reads(name, &implicit, &stored);
+    compare_training(name, &implicit, &stored);
+
+    // Views (dp shards of a loaded set, NUMA slices) and clones (replicas)
+    char what[96];
+    const size_t view_start = 12345, view_count = 98765;
+    Dataset implicit_view, stored_view, clone;
+    dataset_view(&implicit_view, &implicit, view_start, view_count);
+    dataset_view(&stored_view, &stored, view_start, view_count);
+    snprintf(what, sizeof(what), "%s view", name);
+    compare_reads(what, &implicit_view, &stored_view);
+    if (dataset_clone(&clone, &implicit_view, NULL) == 0) {
+        snprintf(what, sizeof(what), "%s clone of view", name);
+        compare_reads(what, &clone, &stored_view);
+        dataset_free(&clone);
+    }
+
+    dataset_free(&stored);
+    dataset_free(&implicit);
+}
+
+static uint64_t float_checksum(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+// The order-independent checksum gen bench prints
+static void check_golden() {
+    GeneratorConfig config;
+    generator_defaults(&config);
+    Dataset data;
+    generator_implicit(&data, &config, 0, GOLDEN_SAMPLES);
+
+    uint64_t checksum = 0;
+    for (size_t start = 0; start < data.size; start += DATASET_CHUNK) {
+        DatasetChunk chunk;
+        size_t n = dataset_chunk(&data, start, DATASET_CHUNK, &chunk);
+        for (size_t i = 0; i < n; i++) {
+            checksum += (float_checksum(chunk.x[i]) << 32 | float_checksum(chunk.y[i])) ^
+                        ((uint64_t)chunk.data_sheet[i] * 0x9E3779B97F4A7C15ull) ^ (start + i);
+        }
+    }
+    if (checksum != GOLDEN_CHECKSUM) {
+        printf("FAIL golden: checksum %016llx, expected %016llx\n", (unsigned long long)checksum,
+               (unsigned long long)GOLDEN_CHECKSUM);
+        failures++;
+    }
+}
+
+// x and y columns of one seed draw from separate streams
+static void check_random_x() {
+    const DatasetColumn x = { .kind = COLUMN_RANDOM, .noise = 1.0f, .seed = 42 };
+    const DatasetColumn y = { .kind = COLUMN_RANDOM, .noise = 1.0f, .seed = 42 };
+    enum { COUNT = 4096 };
+    static float xs[COUNT], zeros[COUNT + 1], ys[COUNT + 1];
+    generator_column(&x, 0, COUNT, NULL, xs);
+    generator_column(&y, 0, COUNT + 1, zeros, ys);
+    int same_sample = 0, next_sample = 0;
+    for (int i = 0; i < COUNT; i++) {
+        same_sample += xs[i] == ys[i];
+        next_sample += xs[i] == ys[i + 1];
+    }
+    // Equal 24-bit draws by chance: expect well under one in 4096
+    if (same_sample > 2 || next_sample > 2) {
+        printf("FAIL random x: %d/%d values equal the sample's y noise, %d the next sample's\n",
+               same_sample, COUNT, next_sample);
+        failures++;
+    }
+}
+
+static void check_sheet_clamp() {
+    const float values[] = { -3.0f, 0.0f, 7.9f, 255.0f, 300.0f, 1e30f };
+    const unsigned char expected[] = { 0, 0, 7, 255, 255, 255 };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        const DatasetColumn column = { .kind = COLUMN_CONSTANT, .value = values[i] };
+        unsigned char out[3];
+        generator_column_sheet(&column, 0, 3, out);
+        if (out[0] != expected[i] || out[2] != expected[i]) {
+            printf("FAIL sheet %g: byte %d, expected %d\n", values[i], out[0], expected[i]);
+            failures++;
+        }
+    }
+}
+
+int main() {
+    check_golden();
+    check_random_x();
+    check_sheet_clamp();
+
+    GeneratorConfig config;
+    generator_defaults(&config);
+    check_config("defaults", &config, 0);
+    check_config("defaults, shard from 1000003", &config, 1000003);
+
+    config.seed = 7;
+    config.slope = -0.75f;
+    config.intercept = 3.25f;
+    config.noise = 0.1f;
+    const float probs[8] = { 0.0f, 1.0f, 0.1f, 0.9f, 0.5f, 0.25f, 0.0f, 0.75f };
+    memcpy(config.sheet_prob, probs, sizeof(probs));
+    check_config("custom", &config, 0);
+
+    for (int bit = 0; bit < 8; bit++) {
+        config.sheet_prob[bit] = 0.0f;
+    }
+    check_config("no sheets", &config, 777);
+
+    if (failures) {
+        printf("%d failure(s)\n", failures);
+        return 1;
+    }
+    printf("Implicit datasets read and train bit-identically to stored ones.\n");
+    return 0;
+}